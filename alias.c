@@ -176,7 +176,7 @@ remove_alias (name)
     {
       free_alias_data (elt->data);
       free (elt->key);		/* alias name */
-      free (elt);		/* XXX */
+      hash_free_item (elt);
 #if defined (PROGRAMMABLE_COMPLETION)
       set_itemlist_dirty (&it_aliases);
 #endif
@@ -717,10 +717,11 @@ ARRAY	*a;
 
 	if (a == 0 || array_empty(a))
 		return((WORD_LIST *)NULL);
+	/* Walk the array backwards so the list is built in order. */
 	list = (WORD_LIST *)NULL;
-	for (ae = element_forw(a->head); ae != a->head; ae = element_forw(ae))
+	for (ae = element_back(a->head); ae != a->head; ae = element_back(ae))
 		list = make_word_list (make_bare_word(element_value(ae)), list);
-	return (REVERSE_LIST(list, WORD_LIST *));
+	return (list);
 }
 
 ARRAY *
@@ -746,12 +747,12 @@ ARRAY	*a;
 	if (a == 0 || array_empty(a))
 		return((WORD_LIST *)NULL);
 	list = (WORD_LIST *)NULL;
-	for (ae = element_forw(a->head); ae != a->head; ae = element_forw(ae)) {
+	for (ae = element_back(a->head); ae != a->head; ae = element_back(ae)) {
 		t = itos(element_index(ae));
 		list = make_word_list (make_bare_word(t), list);
 		free(t);
 	}
-	return (REVERSE_LIST(list, WORD_LIST *));
+	return (list);
 }
 
 ARRAY *
@@ -93,7 +93,7 @@ convert_var_to_assoc (var)
      SHELL_VAR *var;
 {
   char *oldval;
-  HASH_TABLE *hash;
+  ASSOC_TABLE *hash;
 
   oldval = value_cell (var);
   hash = assoc_create (0);
@@ -415,7 +415,7 @@ assign_compound_array_list (var, nlist, flags)
      int flags;
 {
   ARRAY *a;
-  HASH_TABLE *h;
+  ASSOC_TABLE *h;
   WORD_LIST *list;
   char *w, *val, *nval;
   int len, iflags;
@@ -423,7 +423,7 @@ assign_compound_array_list (var, nlist, flags)
   char *akey;
 
   a = (var && array_p (var)) ? array_cell (var) : (ARRAY *)0;
-  h = (var && assoc_p (var)) ? assoc_cell (var) : (HASH_TABLE *)0;
+  h = (var && assoc_p (var)) ? assoc_cell (var) : (ASSOC_TABLE *)0;
 
   akey = (char *)0;
   ind = 0;
@@ -1,7 +1,8 @@
 /*
  * assoc.c - functions to manipulate associative arrays
  *
- * Associative arrays are standard shell hash tables.
+ * Associative arrays are insertion-ordered tables with an open-addressed
+ * index; see assoc.h.
  *
  * Chet Ramey
  * chet@ins.cwru.edu
@@ -44,188 +45,380 @@
 #include "assoc.h"
 #include "builtins/common.h"
 
-static WORD_LIST *assoc_to_word_list_internal __P((HASH_TABLE *, int));
+#define ASSOC_EMPTY	-1	/* index slot never used */
+#define ASSOC_DELETED	-2	/* index slot whose element was removed */
 
-/* assoc_create == hash_create */
+#define ASSOC_MINSIZE	8	/* smallest index, must be a power of two */
+
+/* Rebuild the index once the filled slots, tombstones included, would
+   pass three quarters of it. */
+#define ASSOC_OVERLOADED(h, n)	(((n) * 4) > ((h)->isize * 3))
+
+static int assoc_lookup __P((ASSOC_TABLE *, const char *, unsigned int, int *));
+static void assoc_rehash __P((ASSOC_TABLE *, int));
+static WORD_LIST *assoc_to_word_list_internal __P((ASSOC_TABLE *, int));
+
+ASSOC_TABLE *
+assoc_create (n)
+     int n;
+{
+  ASSOC_TABLE *h;
+
+  h = (ASSOC_TABLE *)xmalloc (sizeof (ASSOC_TABLE));
+  h->entries = (ASSOC_ENTRY *)NULL;
+  h->index = (int *)NULL;
+  h->nentries = h->nused = h->esize = h->isize = h->nfilled = 0;
+
+  /* N is a hint about how many elements the table will hold */
+  if (n > 0)
+    assoc_rehash (h, n);
+  return h;
+}
+
+/* Return the position in H->entries of the element with key KEY, whose
+   hash is HV, or -1 if there isn't one.  If SLOTP is non-null, set it to
+   the index slot that refers to the element, or if there is no element,
+   the slot where one with KEY should go. */
+static int
+assoc_lookup (h, key, hv, slotp)
+     ASSOC_TABLE *h;
+     const char *key;
+     unsigned int hv;
+     int *slotp;
+{
+  register int i, e, mask, avail;
+
+  avail = -1;
+  mask = h->isize - 1;
+  for (i = hv & mask; ; i = (i + 1) & mask)
+    {
+      e = h->index[i];
+      if (e == ASSOC_EMPTY)
+	{
+	  if (slotp)
+	    *slotp = (avail >= 0) ? avail : i;
+	  return -1;
+	}
+      else if (e == ASSOC_DELETED)
+	{
+	  if (avail < 0)
+	    avail = i;
+	}
+      else if (h->entries[e].khash == hv && STREQ (h->entries[e].key, key))
+	{
+	  if (slotp)
+	    *slotp = i;
+	  return e;
+	}
+    }
+}
+
+/* Squeeze the holes out of H's elements and build a new index for it,
+   big enough to hold N elements at half load.  The elements stay in the
+   order in which they were inserted. */
+static void
+assoc_rehash (h, n)
+     ASSOC_TABLE *h;
+     int n;
+{
+  register int i, j, mask;
+
+  if (n < h->nentries)
+    n = h->nentries;
+
+  for (i = j = 0; i < h->nused; i++)
+    if (h->entries[i].key)
+      {
+	if (i != j)
+	  h->entries[j] = h->entries[i];
+	j++;
+      }
+  h->nused = j;
+
+  if (h->esize < n)
+    {
+      h->esize = n;
+      h->entries = (ASSOC_ENTRY *)xrealloc (h->entries, h->esize * sizeof (ASSOC_ENTRY));
+    }
+
+  for (h->isize = ASSOC_MINSIZE; h->isize < n * 2; h->isize <<= 1)
+    ;
+  h->index = (int *)xrealloc (h->index, h->isize * sizeof (int));
+  for (i = 0; i < h->isize; i++)
+    h->index[i] = ASSOC_EMPTY;
+
+  mask = h->isize - 1;
+  for (j = 0; j < h->nused; j++)
+    {
+      for (i = h->entries[j].khash & mask; h->index[i] != ASSOC_EMPTY; i = (i + 1) & mask)
+	;
+      h->index[i] = j;
+    }
+  h->nfilled = h->nused;
+}
+
+ASSOC_TABLE *
+assoc_copy (h)
+     ASSOC_TABLE *h;
+{
+  ASSOC_TABLE *new_table;
+  ASSOC_ENTRY *e;
+  int i;
+
+  if (h == 0)
+    return ((ASSOC_TABLE *)NULL);
+
+  new_table = assoc_create (h->nentries);
+  for (i = 0; i < h->nused; i++)
+    {
+      e = h->entries + i;
+      if (e->key)
+	assoc_insert (new_table, savestring (e->key), e->data);
+    }
+  return new_table;
+}
 
 void
 assoc_dispose (hash)
-     HASH_TABLE *hash;
+     ASSOC_TABLE *hash;
 {
   if (hash)
     {
-      hash_flush (hash, 0);
-      hash_dispose (hash);
+      assoc_flush (hash);
+      free (hash);
     }
 }
 
 void
 assoc_flush (hash)
-     HASH_TABLE *hash;
+     ASSOC_TABLE *hash;
 {
-  hash_flush (hash, 0);
+  register int i;
+
+  if (hash == 0)
+    return;
+
+  for (i = 0; i < hash->nused; i++)
+    if (hash->entries[i].key)
+      {
+	free (hash->entries[i].key);
+	FREE (hash->entries[i].data);
+      }
+
+  FREE (hash->entries);
+  FREE (hash->index);
+  hash->entries = (ASSOC_ENTRY *)NULL;
+  hash->index = (int *)NULL;
+  hash->nentries = hash->nused = hash->esize = hash->isize = hash->nfilled = 0;
 }
      
 int
 assoc_insert (hash, key, value)
-     HASH_TABLE *hash;
+     ASSOC_TABLE *hash;
      char *key;
      char *value;
 {
-  BUCKET_CONTENTS *b;
-
-  b = hash_search (key, hash, HASH_CREATE);
-  if (b == 0)
-    return -1;
-  /* If we are overwriting an existing element's value, we're not going to
-     use the key.  Nothing in the array assignment code path frees the key
-     string, so we can free it here to avoid a memory leak. */
-  if (b->key != key)
-    free (key);
-  FREE (b->data);
-  b->data = value ? savestring (value) : (char *)0;
+  ASSOC_ENTRY *e;
+  unsigned int hv;
+  int i, slot;
+
+  hv = hash_string (key);
+  i = hash->index ? assoc_lookup (hash, key, hv, &slot) : -1;
+  if (i >= 0)
+    {
+      /* If we are overwriting an existing element's value, we're not going
+	 to use the key.  Nothing in the array assignment code path frees
+	 the key string, so we can free it here to avoid a memory leak. */
+      e = hash->entries + i;
+      free (key);
+      FREE (e->data);
+      e->data = value ? savestring (value) : (char *)0;
+      return (0);
+    }
+
+  /* Make room for the new element.  If most of the element array is
+     holes, squeezing them out makes the room; otherwise it doubles. */
+  if (hash->index == 0 || ASSOC_OVERLOADED (hash, hash->nfilled + 1) ||
+	(hash->nused == hash->esize && hash->nentries < hash->nused / 2))
+    {
+      assoc_rehash (hash, hash->nentries + 1);
+      assoc_lookup (hash, key, hv, &slot);
+    }
+  if (hash->nused == hash->esize)
+    {
+      hash->esize *= 2;
+      hash->entries = (ASSOC_ENTRY *)xrealloc (hash->entries, hash->esize * sizeof (ASSOC_ENTRY));
+    }
+
+  if (hash->index[slot] == ASSOC_EMPTY)
+    hash->nfilled++;
+  hash->index[slot] = hash->nused;
+
+  e = hash->entries + hash->nused++;
+  e->key = key;
+  e->data = value ? savestring (value) : (char *)0;
+  e->khash = hv;
+  hash->nentries++;
   return (0);
 }
 
 void
 assoc_remove (hash, string)
-     HASH_TABLE *hash;
+     ASSOC_TABLE *hash;
      char *string;
 {
-  BUCKET_CONTENTS *b;
-
-  b = hash_remove (string, hash, 0);
-  if (b)
-    {
-      free ((char *)b->data);
-      free (b->key);
-      free (b);
-    }
+  ASSOC_ENTRY *e;
+  int i, slot;
+
+  if (hash == 0 || hash->nentries == 0)
+    return;
+
+  i = assoc_lookup (hash, string, hash_string (string), &slot);
+  if (i < 0)
+    return;
+
+  e = hash->entries + i;
+  free (e->key);
+  FREE (e->data);
+  e->key = e->data = (char *)NULL;
+  hash->index[slot] = ASSOC_DELETED;
+  hash->nentries--;
+
+  /* Holes at the end of the element array can be reused right away. */
+  while (hash->nused > 0 && hash->entries[hash->nused - 1].key == 0)
+    hash->nused--;
 }
 
 char *
 assoc_reference (hash, string)
-     HASH_TABLE *hash;
+     ASSOC_TABLE *hash;
      char *string;
 {
-  BUCKET_CONTENTS *b;
+  int i;
 
-  if (hash == 0)
+  if (hash == 0 || hash->nentries == 0)
     return (char *)0;
 
-  b = hash_search (string, hash, 0);
-  return (b ? (char *)b->data : 0);
+  i = assoc_lookup (hash, string, hash_string (string), (int *)NULL);
+  return (i >= 0 ? hash->entries[i].data : (char *)0);
 }
 
 /* Quote the data associated with each element of the hash table ASSOC,
    using quote_string */
-HASH_TABLE *
+ASSOC_TABLE *
 assoc_quote (h)
-     HASH_TABLE *h;
+     ASSOC_TABLE *h;
 {
   int i;
-  BUCKET_CONTENTS *tlist;
+  ASSOC_ENTRY *e;
   char *t;
 
   if (h == 0 || assoc_empty (h))
-    return ((HASH_TABLE *)NULL);
+    return ((ASSOC_TABLE *)NULL);
   
-  for (i = 0; i < h->nbuckets; i++)
-    for (tlist = hash_items (i, h); tlist; tlist = tlist->next)
-      {
-	t = quote_string ((char *)tlist->data);
-	FREE (tlist->data);
-	tlist->data = t;
-      }
+  for (i = 0; i < h->nused; i++)
+    {
+      e = h->entries + i;
+      if (e->key == 0)
+	continue;
+      t = quote_string (e->data);
+      FREE (e->data);
+      e->data = t;
+    }
 
   return h;
 }
 
 /* Quote escape characters in the data associated with each element
    of the hash table ASSOC, using quote_escapes */
-HASH_TABLE *
+ASSOC_TABLE *
 assoc_quote_escapes (h)
-     HASH_TABLE *h;
+     ASSOC_TABLE *h;
 {
   int i;
-  BUCKET_CONTENTS *tlist;
+  ASSOC_ENTRY *e;
   char *t;
 
   if (h == 0 || assoc_empty (h))
-    return ((HASH_TABLE *)NULL);
+    return ((ASSOC_TABLE *)NULL);
   
-  for (i = 0; i < h->nbuckets; i++)
-    for (tlist = hash_items (i, h); tlist; tlist = tlist->next)
-      {
-	t = quote_escapes ((char *)tlist->data);
-	FREE (tlist->data);
-	tlist->data = t;
-      }
+  for (i = 0; i < h->nused; i++)
+    {
+      e = h->entries + i;
+      if (e->key == 0)
+	continue;
+      t = quote_escapes (e->data);
+      FREE (e->data);
+      e->data = t;
+    }
 
   return h;
 }
 
-HASH_TABLE *
+ASSOC_TABLE *
 assoc_dequote (h)
-     HASH_TABLE *h;
+     ASSOC_TABLE *h;
 {
   int i;
-  BUCKET_CONTENTS *tlist;
+  ASSOC_ENTRY *e;
   char *t;
 
   if (h == 0 || assoc_empty (h))
-    return ((HASH_TABLE *)NULL);
+    return ((ASSOC_TABLE *)NULL);
   
-  for (i = 0; i < h->nbuckets; i++)
-    for (tlist = hash_items (i, h); tlist; tlist = tlist->next)
-      {
-	t = dequote_string ((char *)tlist->data);
-	FREE (tlist->data);
-	tlist->data = t;
-      }
+  for (i = 0; i < h->nused; i++)
+    {
+      e = h->entries + i;
+      if (e->key == 0)
+	continue;
+      t = dequote_string (e->data);
+      FREE (e->data);
+      e->data = t;
+    }
 
   return h;
 }
 
-HASH_TABLE *
+ASSOC_TABLE *
 assoc_dequote_escapes (h)
-     HASH_TABLE *h;
+     ASSOC_TABLE *h;
 {
   int i;
-  BUCKET_CONTENTS *tlist;
+  ASSOC_ENTRY *e;
   char *t;
 
   if (h == 0 || assoc_empty (h))
-    return ((HASH_TABLE *)NULL);
+    return ((ASSOC_TABLE *)NULL);
   
-  for (i = 0; i < h->nbuckets; i++)
-    for (tlist = hash_items (i, h); tlist; tlist = tlist->next)
-      {
-	t = dequote_escapes ((char *)tlist->data);
-	FREE (tlist->data);
-	tlist->data = t;
-      }
+  for (i = 0; i < h->nused; i++)
+    {
+      e = h->entries + i;
+      if (e->key == 0)
+	continue;
+      t = dequote_escapes (e->data);
+      FREE (e->data);
+      e->data = t;
+    }
 
   return h;
 }
 
-HASH_TABLE *
+ASSOC_TABLE *
 assoc_remove_quoted_nulls (h)
-     HASH_TABLE *h;
+     ASSOC_TABLE *h;
 {
   int i;
-  BUCKET_CONTENTS *tlist;
-  char *t;
+  ASSOC_ENTRY *e;
 
   if (h == 0 || assoc_empty (h))
-    return ((HASH_TABLE *)NULL);
+    return ((ASSOC_TABLE *)NULL);
   
-  for (i = 0; i < h->nbuckets; i++)
-    for (tlist = hash_items (i, h); tlist; tlist = tlist->next)
-      {
-	t = remove_quoted_nulls ((char *)tlist->data);
-	tlist->data = t;
-      }
+  for (i = 0; i < h->nused; i++)
+    {
+      e = h->entries + i;
+      if (e->key)
+	e->data = remove_quoted_nulls (e->data);
+    }
 
   return h;
 }
@@ -236,7 +429,7 @@ assoc_remove_quoted_nulls (h)
  */
 char *
 assoc_subrange (hash, start, nelem, starsub, quoted)
-HASH_TABLE *hash;
+ASSOC_TABLE *hash;
 arrayind_t start, nelem;
 int starsub, quoted;
 {
@@ -275,26 +468,28 @@ int starsub, quoted;
 
 char *
 assoc_patsub (h, pat, rep, mflags)
-     HASH_TABLE *h;
+     ASSOC_TABLE *h;
      char *pat, *rep;
      int mflags;
 {
-  BUCKET_CONTENTS *tlist;
+  ASSOC_ENTRY *e;
   int i, slen;
-  HASH_TABLE *h2;
+  ASSOC_TABLE *h2;
   char	*t, *sifs, *ifs;
 
   if (h == 0 || assoc_empty (h))
     return ((char *)NULL);
 
   h2 = assoc_copy (h);
-  for (i = 0; i < h2->nbuckets; i++)
-    for (tlist = hash_items (i, h2); tlist; tlist = tlist->next)
-      {
-	t = pat_subst ((char *)tlist->data, pat, rep, mflags);
-	FREE (tlist->data);
-	tlist->data = t;
-      }
+  for (i = 0; i < h2->nused; i++)
+    {
+      e = h2->entries + i;
+      if (e->key == 0)
+	continue;
+      t = pat_subst (e->data, pat, rep, mflags);
+      FREE (e->data);
+      e->data = t;
+    }
 
   if (mflags & MATCH_QUOTED)
     assoc_quote (h2);
@@ -333,27 +528,29 @@ assoc_patsub (h, pat, rep, mflags)
 
 char *
 assoc_modcase (h, pat, modop, mflags)
-     HASH_TABLE *h;
+     ASSOC_TABLE *h;
      char *pat;
      int modop;
      int mflags;
 {
-  BUCKET_CONTENTS *tlist;
+  ASSOC_ENTRY *e;
   int i, slen;
-  HASH_TABLE *h2;
+  ASSOC_TABLE *h2;
   char	*t, *sifs, *ifs;
 
   if (h == 0 || assoc_empty (h))
     return ((char *)NULL);
 
   h2 = assoc_copy (h);
-  for (i = 0; i < h2->nbuckets; i++)
-    for (tlist = hash_items (i, h2); tlist; tlist = tlist->next)
-      {
-	t = sh_modcase ((char *)tlist->data, pat, modop);
-	FREE (tlist->data);
-	tlist->data = t;
-      }
+  for (i = 0; i < h2->nused; i++)
+    {
+      e = h2->entries + i;
+      if (e->key == 0)
+	continue;
+      t = sh_modcase (e->data, pat, modop);
+      FREE (e->data);
+      e->data = t;
+    }
 
   if (mflags & MATCH_QUOTED)
     assoc_quote (h2);
@@ -392,13 +589,13 @@ assoc_modcase (h, pat, modop, mflags)
 
 char *
 assoc_to_assign (hash, quoted)
-     HASH_TABLE *hash;
+     ASSOC_TABLE *hash;
      int quoted;
 {
   char *ret;
   char *istr, *vstr;
   int i, rsize, rlen, elen;
-  BUCKET_CONTENTS *tlist;
+  ASSOC_ENTRY *tlist;
 
   if (hash == 0 || assoc_empty (hash))
     return (char *)0;
@@ -407,39 +604,41 @@ assoc_to_assign (hash, quoted)
   ret[0] = '(';
   rlen = 1;
 
-  for (i = 0; i < hash->nbuckets; i++)
-    for (tlist = hash_items (i, hash); tlist; tlist = tlist->next)
-      {
+  for (i = 0; i < hash->nused; i++)
+    {
+      tlist = hash->entries + i;
+      if (tlist->key == 0)
+	continue;
 #if 1
-	if (sh_contains_shell_metas (tlist->key))
-	  istr = sh_double_quote (tlist->key);
-	else
-	  istr = tlist->key;	
+      if (sh_contains_shell_metas (tlist->key))
+	istr = sh_double_quote (tlist->key);
+      else
+	istr = tlist->key;	
 #else
-	istr = tlist->key;
+      istr = tlist->key;
 #endif
-	vstr = tlist->data ? sh_double_quote ((char *)tlist->data) : (char *)0;
+      vstr = tlist->data ? sh_double_quote ((char *)tlist->data) : (char *)0;
 
-	elen = STRLEN (istr) + 8 + STRLEN (vstr);
-	RESIZE_MALLOCED_BUFFER (ret, rlen, (elen+1), rsize, rsize);
+      elen = STRLEN (istr) + 8 + STRLEN (vstr);
+      RESIZE_MALLOCED_BUFFER (ret, rlen, (elen+1), rsize, rsize);
 
-	ret[rlen++] = '[';
-	strcpy (ret+rlen, istr);
-	rlen += STRLEN (istr);
-	ret[rlen++] = ']';
-	ret[rlen++] = '=';
-	if (vstr)
-	  {
-	    strcpy (ret + rlen, vstr);
-	    rlen += STRLEN (vstr);
-	  }
-	ret[rlen++] = ' ';
+      ret[rlen++] = '[';
+      strcpy (ret+rlen, istr);
+      rlen += STRLEN (istr);
+      ret[rlen++] = ']';
+      ret[rlen++] = '=';
+      if (vstr)
+	{
+	  strcpy (ret + rlen, vstr);
+	  rlen += STRLEN (vstr);
+	}
+      ret[rlen++] = ' ';
 
 
-	if (istr != tlist->key)
-	  FREE (istr);
+      if (istr != tlist->key)
+	FREE (istr);
 
-	FREE (vstr);
+      FREE (vstr);
     }
 
   RESIZE_MALLOCED_BUFFER (ret, rlen, 1, rsize, 8);
@@ -458,51 +657,54 @@ assoc_to_assign (hash, quoted)
 
 static WORD_LIST *
 assoc_to_word_list_internal (h, t)
-     HASH_TABLE *h;
+     ASSOC_TABLE *h;
      int t;
 {
   WORD_LIST *list;
   int i;
-  BUCKET_CONTENTS *tlist;
+  ASSOC_ENTRY *e;
   char *w;
 
   if (h == 0 || assoc_empty (h))
     return((WORD_LIST *)NULL);
   list = (WORD_LIST *)NULL;
   
-  for (i = 0; i < h->nbuckets; i++)
-    for (tlist = hash_items (i, h); tlist; tlist = tlist->next)
-      {
-	w = (t == 0) ? (char *)tlist->data : (char *)tlist->key;
-	list = make_word_list (make_bare_word(w), list);
-      }
-  return (REVERSE_LIST(list, WORD_LIST *));
+  /* Work backwards, so the list comes out in insertion order. */
+  for (i = h->nused - 1; i >= 0; i--)
+    {
+      e = h->entries + i;
+      if (e->key == 0)
+	continue;
+      w = (t == 0) ? e->data : e->key;
+      list = make_word_list (make_bare_word(w), list);
+    }
+  return (list);
 }
 
 WORD_LIST *
 assoc_to_word_list (h)
-     HASH_TABLE *h;
+     ASSOC_TABLE *h;
 {
   return (assoc_to_word_list_internal (h, 0));
 }
 
 WORD_LIST *
 assoc_keys_to_word_list (h)
-     HASH_TABLE *h;
+     ASSOC_TABLE *h;
 {
   return (assoc_to_word_list_internal (h, 1));
 }
 
 char *
 assoc_to_string (h, sep, quoted)
-     HASH_TABLE *h;
+     ASSOC_TABLE *h;
      char *sep;
      int quoted;
 {
-  BUCKET_CONTENTS *tlist;
+  ASSOC_ENTRY *e;
   int i;
   char *result, *t, *w;
-  WORD_LIST *list, *l;
+  WORD_LIST *list;
 
   if (h == 0)
     return ((char *)NULL);
@@ -514,20 +716,19 @@ assoc_to_string (h, sep, quoted)
   /* This might be better implemented directly, but it's simple to implement
      by converting to a word list first, possibly quoting the data, then
      using list_string */
-  for (i = 0; i < h->nbuckets; i++)
-    for (tlist = hash_items (i, h); tlist; tlist = tlist->next)
-      {
-	w = (char *)tlist->data;
-	if (w == 0)
-	  continue;
-	t = quoted ? quote_string (w) : savestring (w);
-	list = make_word_list (make_bare_word(t), list);
-	FREE (t);
-      }
-
-  l = REVERSE_LIST(list, WORD_LIST *);
+  for (i = h->nused - 1; i >= 0; i--)
+    {
+      e = h->entries + i;
+      w = e->data;
+      if (e->key == 0 || w == 0)
+	continue;
+      t = quoted ? quote_string (w) : savestring (w);
+      list = make_word_list (make_bare_word(t), list);
+      FREE (t);
+    }
 
-  result = l ? string_list_internal (l, sep) : savestring ("");
+  result = list ? string_list_internal (list, sep) : savestring ("");
+  dispose_words (list);
   return result;
 }
 
@@ -25,37 +25,55 @@
 #include "stdc.h"
 #include "hashlib.h"
 
+/* An associative array keeps its elements in an array in the order they
+   were inserted, and finds them through an open-addressed index of
+   positions in that array.  Removing an element leaves a hole in the
+   element array (an element with a null key) and a tombstone in the
+   index; both are squeezed out the next time the index is rebuilt. */
+typedef struct assoc_entry {
+  char *key;			/* null if the element was removed */
+  char *data;
+  unsigned int khash;		/* what key hashes to */
+} ASSOC_ENTRY;
+
+typedef struct assoc_table {
+  ASSOC_ENTRY *entries;		/* the elements, in insertion order */
+  int *index;			/* positions in ENTRIES, by hash */
+  int nentries;			/* how many elements there are */
+  int nused;			/* entries used, including holes */
+  int esize;			/* entries allocated */
+  int isize;			/* index slots, a power of two */
+  int nfilled;			/* index slots not empty, including tombstones */
+} ASSOC_TABLE;
+
 #define assoc_empty(h)		((h)->nentries == 0)
 #define assoc_num_elements(h)	((h)->nentries)
 
-#define assoc_create(n)		(hash_create((n)))
-
-#define assoc_copy(h)		(hash_copy((h), 0))
-
-#define assoc_walk(h, f)	(hash_walk((h), (f))
+extern ASSOC_TABLE *assoc_create __P((int));
+extern ASSOC_TABLE *assoc_copy __P((ASSOC_TABLE *));
 
-extern void assoc_dispose __P((HASH_TABLE *));
-extern void assoc_flush __P((HASH_TABLE *));
+extern void assoc_dispose __P((ASSOC_TABLE *));
+extern void assoc_flush __P((ASSOC_TABLE *));
 
-extern int assoc_insert __P((HASH_TABLE *, char *, char *));
-extern void assoc_remove __P((HASH_TABLE *, char *));
+extern int assoc_insert __P((ASSOC_TABLE *, char *, char *));
+extern void assoc_remove __P((ASSOC_TABLE *, char *));
 
-extern char *assoc_reference __P((HASH_TABLE *, char *));
+extern char *assoc_reference __P((ASSOC_TABLE *, char *));
 
-extern char *assoc_subrange __P((HASH_TABLE *, arrayind_t, arrayind_t, int, int));
-extern char *assoc_patsub __P((HASH_TABLE *, char *, char *, int));
-extern char *assoc_modcase __P((HASH_TABLE *, char *, int, int));
+extern char *assoc_subrange __P((ASSOC_TABLE *, arrayind_t, arrayind_t, int, int));
+extern char *assoc_patsub __P((ASSOC_TABLE *, char *, char *, int));
+extern char *assoc_modcase __P((ASSOC_TABLE *, char *, int, int));
 
-extern HASH_TABLE *assoc_quote __P((HASH_TABLE *));
-extern HASH_TABLE *assoc_quote_escapes __P((HASH_TABLE *));
-extern HASH_TABLE *assoc_dequote __P((HASH_TABLE *));
-extern HASH_TABLE *assoc_dequote_escapes __P((HASH_TABLE *));
-extern HASH_TABLE *assoc_remove_quoted_nulls __P((HASH_TABLE *));
+extern ASSOC_TABLE *assoc_quote __P((ASSOC_TABLE *));
+extern ASSOC_TABLE *assoc_quote_escapes __P((ASSOC_TABLE *));
+extern ASSOC_TABLE *assoc_dequote __P((ASSOC_TABLE *));
+extern ASSOC_TABLE *assoc_dequote_escapes __P((ASSOC_TABLE *));
+extern ASSOC_TABLE *assoc_remove_quoted_nulls __P((ASSOC_TABLE *));
 
-extern char *assoc_to_assign __P((HASH_TABLE *, int));
+extern char *assoc_to_assign __P((ASSOC_TABLE *, int));
 
-extern WORD_LIST *assoc_to_word_list __P((HASH_TABLE *));
-extern WORD_LIST *assoc_keys_to_word_list __P((HASH_TABLE *));
+extern WORD_LIST *assoc_to_word_list __P((ASSOC_TABLE *));
+extern WORD_LIST *assoc_keys_to_word_list __P((ASSOC_TABLE *));
 
-extern char *assoc_to_string __P((HASH_TABLE *, char *, int));
+extern char *assoc_to_string __P((ASSOC_TABLE *, char *, int));
 #endif /* _ASSOC_H_ */
@@ -64,6 +64,7 @@ extern int errno;
 #endif
 
 static int histignore_item_func __P((struct ign *));
+static int hist_log_append __P((int, char *));
 static int check_history_control __P((char *));
 static void hc_erasedups __P((char *));
 static void really_add_history __P((char *));
@@ -146,6 +147,23 @@ int literal_history;
    exit, even if the history has been stifled. */
 int force_append_history;
 
+/* Non-zero means to treat the history file as an append-only log shared
+   by all the shells that use it: saving history only ever appends to
+   it, `history -n' reads just the bytes appended since the last read,
+   and the file is cut back to $HISTFILESIZE lines only after it has
+   grown to about twice that size.  Set by `shopt -s histlog'. */
+int history_log_mode;
+
+/* Our place in the history file when it is used as a log: which file,
+   how far into it we have read, and the byte ranges after that which
+   hold lines we appended ourselves and should not read back in. */
+static char *hist_log_name;
+static dev_t hist_log_dev;
+static ino_t hist_log_ino;
+static off_t hist_log_offset = -1;
+static off_t *hist_log_skip;		/* start and end offset pairs */
+static int hist_log_nskip, hist_log_skipsize;
+
 /* A nit for picking at history saving.  Flags have the following values:
 
    Value == 0 means save all lines parsed by the shell on the history.
@@ -230,6 +248,7 @@ bash_initialize_history ()
   history_quotes_inhibit_expansion = 1;
   history_search_delimiter_chars = ";&()|<>";
   history_inhibit_expansion_function = bash_history_inhibit_expansion;
+  history_lazy_load = 1;
 #if defined (BANG_HISTORY)
   sv_histchars ("histchars");
 #endif
@@ -264,6 +283,7 @@ bash_history_enable ()
   history_expansion_inhibited = 0;
 #endif
   history_inhibit_expansion_function = bash_history_inhibit_expansion;
+  history_lazy_load = 1;
   sv_history_control ("HISTCONTROL");
   sv_histignore ("HISTIGNORE");
 }
@@ -289,9 +309,16 @@ load_history ()
 
   if (hf && *hf && file_exists (hf))
     {
-      read_history (hf);
+      if (history_log_mode)
+	bash_history_log_read (hf);
+      else
+	read_history (hf);
       using_history ();
       history_lines_in_file = where_history ();
+
+      /* We could not tell how long the lines in a log are until now. */
+      if (history_log_mode)
+	sv_histsize ("HISTFILESIZE");
     }
 }
 
@@ -321,16 +348,12 @@ int
 bash_delete_last_history ()
 {
   register int i;
-  HIST_ENTRY **hlist, *histent;
+  HIST_ENTRY *histent;
   int r;
 
-  hlist = history_list ();
-  if (hlist == NULL)
+  if (history_length == 0)
     return 0;
-
-  for (i = 0; hlist[i]; i++)
-    ;
-  i--;
+  i = history_length - 1;
 
   /* History_get () takes a parameter that must be offset by history_base. */
   histent = history_get (history_base + i);	/* Don't free this */
@@ -376,7 +399,7 @@ maybe_append_history (filename)
   struct stat buf;
 
   result = EXECUTION_SUCCESS;
-  if (history_lines_this_session && (history_lines_this_session <= where_history ()))
+  if (history_lines_this_session && (history_lines_this_session <= where_history () || history_log_mode))
     {
       /* If the filename was supplied, then create it if necessary. */
       if (stat (filename, &buf) == -1 && errno == ENOENT)
@@ -389,7 +412,8 @@ maybe_append_history (filename)
 	    }
 	  close (fd);
 	}
-      result = append_history (history_lines_this_session, filename);
+      result = history_log_mode ? hist_log_append (history_lines_this_session, filename)
+				: append_history (history_lines_this_session, filename);
       history_lines_in_file += history_lines_this_session;
       history_lines_this_session = 0;
     }
@@ -424,7 +448,12 @@ maybe_save_shell_history ()
 	     stifled.  If the history has been stifled, rewrite the
 	     history file. */
 	  using_history ();
-	  if (history_lines_this_session <= where_history () || force_append_history)
+	  if (history_log_mode)
+	    {
+	      result = hist_log_append (history_lines_this_session, hf);
+	      history_lines_in_file += history_lines_this_session;
+	    }
+	  else if (history_lines_this_session <= where_history () || force_append_history)
 	    {
 	      result = append_history (history_lines_this_session, hf);
 	      history_lines_in_file += history_lines_this_session;
@@ -442,6 +471,183 @@ maybe_save_shell_history ()
   return (result);
 }
 
+/* Return 1 if our place in the history log is in FILENAME, and SP shows
+   it is still the same file, not one that has replaced it. */
+static int
+hist_log_valid (filename, sp)
+     char *filename;
+     struct stat *sp;
+{
+  if (hist_log_offset < 0 || hist_log_name == 0 || STREQ (filename, hist_log_name) == 0)
+    return 0;
+  return (sp->st_dev == hist_log_dev && sp->st_ino == hist_log_ino && sp->st_size >= hist_log_offset);
+}
+
+/* Remember that we have read FILENAME, described by SP, up to OFFSET. */
+static void
+hist_log_checkpoint (filename, sp, offset)
+     char *filename;
+     struct stat *sp;
+     off_t offset;
+{
+  if (hist_log_name == 0 || STREQ (filename, hist_log_name) == 0)
+    {
+      FREE (hist_log_name);
+      hist_log_name = savestring (filename);
+    }
+  hist_log_dev = sp->st_dev;
+  hist_log_ino = sp->st_ino;
+  hist_log_offset = offset;
+  hist_log_nskip = 0;
+}
+
+/* Append the last N lines in the history list to FILENAME.  If FILENAME
+   is the log we are reading, note where they went, so that reading what
+   other shells have appended since doesn't read them back in. */
+static int
+hist_log_append (n, filename)
+     int n;
+     char *filename;
+{
+  off_t start, end;
+  int r;
+
+  r = append_history_offset (n, filename, &start, &end);
+  if (r || start < 0 || hist_log_offset < 0 || hist_log_name == 0 || STREQ (filename, hist_log_name) == 0)
+    return r;
+
+  if (hist_log_nskip == 0 && start == hist_log_offset)
+    hist_log_offset = end;
+  else
+    {
+      if (hist_log_nskip >= hist_log_skipsize)
+	{
+	  hist_log_skipsize += 8;
+	  hist_log_skip = (off_t *)xrealloc (hist_log_skip, 2 * hist_log_skipsize * sizeof (off_t));
+	}
+      hist_log_skip[2 * hist_log_nskip] = start;
+      hist_log_skip[2 * hist_log_nskip + 1] = end;
+      hist_log_nskip++;
+    }
+  return r;
+}
+
+/* Read the lines other shells have appended to the history log FILENAME
+   since we last read it.  If we haven't read it yet, or it has been
+   replaced, skip the first history_lines_in_file lines, as `history -n'
+   does for an ordinary history file. */
+int
+bash_history_log_read (filename)
+     char *filename;
+{
+  struct stat sb;
+  off_t off;
+  int i, r;
+
+  if (stat (filename, &sb) < 0)
+    return (errno);
+
+  if (hist_log_valid (filename, &sb) == 0)
+    {
+      off = -1;
+      r = read_history_offset (filename, history_lines_in_file, &off, -1);
+      if (r == 0)
+	hist_log_checkpoint (filename, &sb, off);
+      else
+	hist_log_offset = -1;
+      return r;
+    }
+
+  off = hist_log_offset;
+  for (i = r = 0; r == 0 && i < hist_log_nskip; i++)
+    {
+      r = read_history_offset (filename, 0, &off, hist_log_skip[2 * i]);
+      off = hist_log_skip[2 * i + 1];
+    }
+  if (r == 0)
+    r = read_history_offset (filename, 0, &off, -1);
+
+  hist_log_offset = r ? -1 : off;
+  hist_log_nskip = 0;
+  return r;
+}
+
+/* The number of recent history entries hist_log_linesize looks at. */
+#define HIST_LOG_SAMPLE	100
+
+/* Return the average number of bytes each of the most recent entries in
+   the history list takes up in the history file.  Looking at them all
+   would read the whole history file into the history list. */
+static off_t
+hist_log_linesize ()
+{
+  HIST_ENTRY *histent;
+  off_t nbytes;
+  int i, n;
+
+  if (history_length == 0)
+    return 0;
+
+  n = (history_length < HIST_LOG_SAMPLE) ? history_length : HIST_LOG_SAMPLE;
+  for (i = 0, nbytes = 0; i < n; i++)
+    {
+      histent = history_get (history_base + history_length - n + i);
+      nbytes += strlen (histent->line) + 1;
+      if (history_write_timestamps && histent->timestamp && histent->timestamp[0])
+	nbytes += strlen (histent->timestamp) + 1;
+    }
+  return (nbytes / n + 1);
+}
+
+/* Truncate the history file FILENAME to its last LINES lines.  Other
+   shells may be appending to a history log at any time, so rather than
+   rewriting it in place whenever it holds more than LINES lines, wait
+   until it is about twice that size and then compact it, which spreads
+   the cost of rewriting it over many sessions. */
+void
+bash_history_truncate_file (filename, lines)
+     char *filename;
+     int lines;
+{
+  struct stat sb;
+  off_t linesize, removed;
+  int i, j, valid;
+
+  if (history_log_mode == 0)
+    {
+      history_truncate_file (filename, lines);
+      return;
+    }
+
+  if (filename == 0 || *filename == 0 || stat (filename, &sb) < 0)
+    return;
+  linesize = hist_log_linesize ();
+  if (linesize == 0 || sb.st_size <= 2 * (off_t)lines * linesize)
+    return;
+
+  valid = hist_log_valid (filename, &sb);
+  if (history_compact_file (filename, lines, &removed) != 0 || removed == 0)
+    return;
+
+  /* Carry our place over into the compacted file. */
+  if (valid == 0 || stat (filename, &sb) < 0)
+    {
+      hist_log_offset = -1;
+      return;
+    }
+  hist_log_dev = sb.st_dev;
+  hist_log_ino = sb.st_ino;
+  hist_log_offset = (hist_log_offset > removed) ? hist_log_offset - removed : 0;
+  for (i = j = 0; i < hist_log_nskip; i++)
+    if (hist_log_skip[2 * i + 1] > removed)
+      {
+	hist_log_skip[2 * j] = (hist_log_skip[2 * i] > removed) ? hist_log_skip[2 * i] - removed : 0;
+	hist_log_skip[2 * j + 1] = hist_log_skip[2 * i + 1] - removed;
+	j++;
+      }
+  hist_log_nskip = j;
+}
+
 #if defined (READLINE)
 /* Tell readline () that we have some text for it to edit. */
 static void
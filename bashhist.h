@@ -34,6 +34,7 @@ extern int remember_on_history;
 extern int enable_history_list;		/* value for `set -o history' */
 extern int literal_history;		/* controlled by `shopt lithist' */
 extern int force_append_history;
+extern int history_log_mode;
 extern int history_lines_this_session;
 extern int history_lines_in_file;
 extern int history_expansion;
@@ -58,6 +59,8 @@ extern void load_history __P((void));
 extern void save_history __P((void));
 extern int maybe_append_history __P((char *));
 extern int maybe_save_shell_history __P((void));
+extern int bash_history_log_read __P((char *));
+extern void bash_history_truncate_file __P((char *, int));
 extern char *pre_process_line __P((char *, int, int));
 extern void maybe_add_history __P((char *));
 extern void bash_add_history __P((char *));
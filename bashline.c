@@ -1294,6 +1294,11 @@ attempt_shell_completion (text, start, end)
   rl_filename_quote_characters = default_filename_quote_characters;
   set_directory_hook ();
 
+  /* The default completions can be listed again without being generated
+     again, but shell functions and commands run for programmable
+     completion expect to be called each time, with COMP_TYPE set. */
+  rl_completion_reuse_matches = 1;
+
   /* Determine if this could be a command word.  It is if it appears at
      the start of the line (ignoring preceding whitespace), or if it
      appears after a character that separates commands.  It cannot be a
@@ -1385,6 +1390,7 @@ attempt_shell_completion (text, start, end)
 	 compopt. */
       if (foundcs)
 	{
+	  rl_completion_reuse_matches = 0;
 	  pcomp_set_readline_variables (foundcs, 1);
 	  /* Turn what the programmable completion code returns into what
 	     readline wants.  I should have made compute_lcd_of_matches
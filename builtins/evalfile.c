@@ -88,26 +88,17 @@ _evalfile (filename, flags)
   struct stat finfo;
   size_t file_size;
   sh_vmsg_func_t *errfunc;
-#if defined (ARRAY_VARS)
-  SHELL_VAR *funcname_v, *nfv, *bash_source_v, *bash_lineno_v;
-  ARRAY *funcname_a, *bash_source_a, *bash_lineno_a;
-#  if defined (DEBUGGER)
+#if defined (ARRAY_VARS) && defined (DEBUGGER)
   SHELL_VAR *bash_argv_v, *bash_argc_v;
   ARRAY *bash_argv_a, *bash_argc_a;
-#  endif
-  char *t, tt[2];
+  char tt[2];
 #endif
 
   USE_VAR(pflags);
 
-#if defined (ARRAY_VARS)
-  GET_ARRAY_FROM_VAR ("FUNCNAME", funcname_v, funcname_a);
-  GET_ARRAY_FROM_VAR ("BASH_SOURCE", bash_source_v, bash_source_a);
-  GET_ARRAY_FROM_VAR ("BASH_LINENO", bash_lineno_v, bash_lineno_a);
-#  if defined (DEBUGGER)
+#if defined (ARRAY_VARS) && defined (DEBUGGER)
   GET_ARRAY_FROM_VAR ("BASH_ARGV", bash_argv_v, bash_argv_a);
   GET_ARRAY_FROM_VAR ("BASH_ARGC", bash_argc_v, bash_argc_a);
-#  endif
 #endif
   
   fd = open (filename, O_RDONLY);
@@ -227,11 +218,7 @@ file_error_and_exit:
   sourcelevel++;
 
 #if defined (ARRAY_VARS)
-  array_push (bash_source_a, (char *)filename);
-  t = itos (executing_line_number ());
-  array_push (bash_lineno_a, t);
-  free (t);
-  array_push (funcname_a, "source");	/* not exactly right */
+  push_call_frame ("source", (char *)filename, executing_line_number ());	/* not exactly right */
 #  if defined (DEBUGGER)
   /* Have to figure out a better way to do this when `source' is supplied
      arguments */
@@ -275,16 +262,7 @@ file_error_and_exit:
     }
 
 #if defined (ARRAY_VARS)
-  /* These two variables cannot be unset, and cannot be affected by the
-     sourced file. */
-  array_pop (bash_source_a);
-  array_pop (bash_lineno_a);
-
-  /* FUNCNAME can be unset, and so can potentially be changed by the
-     sourced file. */
-  GET_ARRAY_FROM_VAR ("FUNCNAME", nfv, funcname_a);
-  if (nfv == funcname_v)
-    array_pop (funcname_a);
+  pop_call_frame ();
 #  if defined (DEBUGGER)
   if ((flags & FEVAL_NOPUSHARGS) == 0)
     {
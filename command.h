@@ -98,6 +98,8 @@ enum command_type { cm_for, cm_case, cm_while, cm_if, cm_simple, cm_select,
 #define W_ASSIGNASSOC	0x400000	/* word looks like associative array assignment */
 #define W_ARRAYIND	0x800000	/* word is an array index being expanded */
 #define W_ASSNGLOBAL	0x1000000	/* word is a global assignment to declare (declare/typeset -g) */
+#define W_DEQUOTED	0x2000000	/* quote removal has already been performed */
+#define W_BORROWED	0x4000000	/* word's string belongs to someone else; don't free it */
 
 /* Possible values for subshell_environment */
 #define SUBSHELL_ASYNC	0x01	/* subshell caused by `command &' */
@@ -227,12 +229,26 @@ typedef struct pattern_list {
   int flags;
 } PATTERN_LIST;
 
+/* Filled in the first time a CASE_COM is executed, and shared by all the
+   copies of that command.  Clauses whose patterns are all literal strings
+   are found with a hash table lookup instead of expanding and matching
+   each pattern in turn. */
+typedef struct case_dispatch {
+  int refcount;
+  int nclauses;			/* -1 until the table has been built. */
+  int nnonlit;
+  int *nonlit;			/* Indices of clauses that must be matched. */
+  struct hash_table *table;	/* Literal pattern -> indices of clauses.
+				   NULL if there aren't enough literals. */
+} CASE_DISPATCH;
+
 /* The CASE command. */
 typedef struct case_com {
   int flags;			/* See description of CMD flags. */
   int line;			/* line number the `case' keyword appears on */
   WORD_DESC *word;		/* The thing to test. */
   PATTERN_LIST *clauses;	/* The clauses to test against, or NULL. */
+  CASE_DISPATCH *dispatch;	/* Lookup table for literal patterns. */
 } CASE_COM;
 
 /* FOR command. */
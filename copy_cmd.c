@@ -32,6 +32,8 @@
 
 #include "shell.h"
 
+extern sh_obj_cache_t cmdcache, sccache, conncache;
+
 static PATTERN_LIST *copy_case_clause __P((PATTERN_LIST *));
 static PATTERN_LIST *copy_case_clauses __P((PATTERN_LIST *));
 static FOR_COM *copy_for_command __P((FOR_COM *));
@@ -59,7 +61,7 @@ copy_word (w)
   WORD_DESC *new_word;
 
   new_word = make_bare_word (w->word);
-  new_word->flags = w->flags;
+  new_word->flags = w->flags & ~W_BORROWED;
   return (new_word);
 }
 
@@ -69,12 +71,13 @@ WORD_LIST *
 copy_word_list (list)
      WORD_LIST *list;
 {
-  WORD_LIST *new_list;
+  WORD_LIST_BUILDER new_list;
 
-  for (new_list = (WORD_LIST *)NULL; list; list = list->next)
-    new_list = make_word_list (copy_word (list->word), new_list);
+  wlbuild_init (&new_list);
+  for ( ; list; list = list->next)
+    wlbuild_add (&new_list, copy_word (list->word));
 
-  return (REVERSE_LIST (new_list, WORD_LIST *));
+  return (new_list.list);
 }
 
 static PATTERN_LIST *
@@ -248,6 +251,8 @@ copy_case_command (com)
   new_case->line = com->line;
   new_case->word = copy_word (com->word);
   new_case->clauses = copy_case_clauses (com->clauses);
+  if (new_case->dispatch = com->dispatch)
+    new_case->dispatch->refcount++;
   return (new_case);
 }
 
@@ -319,7 +324,7 @@ copy_simple_command (com)
 {
   SIMPLE_COM *new_simple;
 
-  new_simple = (SIMPLE_COM *)xmalloc (sizeof (SIMPLE_COM));
+  ocache_alloc (sccache, SIMPLE_COM, new_simple);
   new_simple->flags = com->flags;
   new_simple->words = copy_word_list (com->words);
   new_simple->redirects = com->redirects ? copy_redirects (com->redirects) : (REDIRECT *)NULL;
@@ -362,7 +367,7 @@ copy_command (command)
   if (command == NULL)
     return (command);
 
-  new_command = (COMMAND *)xmalloc (sizeof (COMMAND));
+  ocache_alloc (cmdcache, COMMAND, new_command);
   FASTCOPY ((char *)command, (char *)new_command, sizeof (COMMAND));
   new_command->flags = command->flags;
   new_command->line = command->line;
@@ -434,7 +439,7 @@ copy_command (command)
 	{
 	  CONNECTION *new_connection;
 
-	  new_connection = (CONNECTION *)xmalloc (sizeof (CONNECTION));
+	  ocache_alloc (conncache, CONNECTION, new_connection);
 	  new_connection->connector = command->value.Connection->connector;
 	  new_connection->first = copy_command (command->value.Connection->first);
 	  new_connection->second = copy_command (command->value.Connection->second);
@@ -30,6 +30,7 @@
 #include "shell.h"
 
 extern sh_obj_cache_t wdcache, wlcache;
+extern sh_obj_cache_t cmdcache, sccache, conncache;
 
 /* Dispose of the command structure passed. */
 void
@@ -116,6 +117,8 @@ dispose_command (command)
 	    p = p->next;
 	    free (t);
 	  }
+	if (c->dispatch)
+	  dispose_case_dispatch (c->dispatch);
 	free (c);
 	break;
       }
@@ -151,7 +154,7 @@ dispose_command (command)
 	c = command->value.Simple;
 	dispose_words (c->words);
 	dispose_redirects (c->redirects);
-	free (c);
+	ocache_free (sccache, SIMPLE_COM, c);
 	break;
       }
 
@@ -162,7 +165,7 @@ dispose_command (command)
 	c = command->value.Connection;
 	dispose_command (c->first);
 	dispose_command (c->second);
-	free (c);
+	ocache_free (conncache, CONNECTION, c);
 	break;
       }
 
@@ -202,7 +205,7 @@ dispose_command (command)
       command_error ("dispose_command", CMDERR_BADTYPE, command->type, 0);
       break;
     }
-  free (command);
+  ocache_free (cmdcache, COMMAND, command);
 }
 
 #if defined (COND_COMMAND)
@@ -224,6 +227,23 @@ dispose_cond_node (cond)
 }
 #endif /* COND_COMMAND */
 
+/* Release a reference to the literal pattern lookup table for a case
+   command, freeing it when the last copy of the command goes away. */
+void
+dispose_case_dispatch (d)
+     CASE_DISPATCH *d;
+{
+  if (--d->refcount > 0)
+    return;
+  if (d->table)
+    {
+      hash_flush (d->table, 0);
+      hash_dispose (d->table);
+    }
+  FREE (d->nonlit);
+  free (d);
+}
+
 void
 dispose_function_def_contents (c)
      FUNCTION_DEF *c;
@@ -246,7 +266,8 @@ void
 dispose_word (w)
      WORD_DESC *w;
 {
-  FREE (w->word);
+  if ((w->flags & W_BORROWED) == 0)
+    FREE (w->word);
   ocache_free (wdcache, WORD_DESC, w);
 }
 
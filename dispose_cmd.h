@@ -34,6 +34,8 @@ extern void dispose_redirects __P((REDIRECT *));
 extern void dispose_cond_node __P((COND_COM *));
 #endif
 
+extern void dispose_case_dispatch __P((CASE_DISPATCH *));
+
 extern void dispose_function_def_contents __P((FUNCTION_DEF *));
 extern void dispose_function_def __P((FUNCTION_DEF *));
 
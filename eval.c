@@ -54,6 +54,10 @@ extern int need_here_doc;
 extern int current_command_number, current_command_line_count, line_number;
 extern int expand_aliases;
 
+#if defined (USING_BASH_MALLOC)
+extern void malloc_release_idle __P((void));
+#endif
+
 static void send_pwd_to_eterm __P((void));
 static sighandler alrm_catcher __P((int));
 
@@ -81,6 +85,14 @@ reader_loop ()
       unlink_fifo_list ();
 #endif /* PROCESS_SUBSTITUTION */
 
+      /* Nothing is being expanded at this point, even if we got here by
+	 a longjmp out of the middle of a command. */
+      arena_release (0);
+      ocache_trim ();
+#if defined (USING_BASH_MALLOC)
+      malloc_release_idle ();
+#endif
+
       if (interactive_shell && signal_is_ignored (SIGINT) == 0)
 	set_signal_handler (SIGINT, sigint_sighandler);
 
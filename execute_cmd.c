@@ -162,6 +162,10 @@ static int time_command __P((COMMAND *, int, int, int, struct fd_bitmap *));
 static intmax_t eval_arith_for_expr __P((WORD_LIST *, int *));
 static int execute_arith_for_command __P((ARITH_FOR_COM *));
 #endif
+static int case_literal_pattern __P((WORD_DESC *));
+static CASE_DISPATCH *case_dispatch_table __P((CASE_COM *));
+static int case_clause_matches __P((PATTERN_LIST *, char *));
+static int case_dispatch_next __P((CASE_DISPATCH *, char *, int, PATTERN_LIST **));
 static int execute_case_command __P((CASE_COM *));
 static int execute_while_command __P((WHILE_COM *));
 static int execute_until_command __P((WHILE_COM *));
@@ -169,6 +173,9 @@ static int execute_while_or_until __P((WHILE_COM *, int));
 static int execute_if_command __P((IF_COM *));
 static int execute_null_command __P((REDIRECT *, int, int, int));
 static void fix_assignment_words __P((WORD_LIST *));
+#if defined (ARRAY_VARS)
+static int can_borrow_array_words __P((SIMPLE_COM *));
+#endif
 static int execute_simple_command __P((SIMPLE_COM *, int, int, int, struct fd_bitmap *));
 static int execute_builtin __P((sh_builtin_func_t *, WORD_LIST *, int, int));
 static int execute_function __P((SHELL_VAR *, WORD_LIST *, int, struct fd_bitmap *, int, int));
@@ -530,6 +537,7 @@ execute_command_internal (command, asynchronous, pipe_in, pipe_out,
   REDIRECT *my_undo_list, *exec_undo_list;
   volatile int last_pid;
   volatile int save_line_number;
+  size_t arena_scope;
 
 #if 0
   if (command == 0 || breaking || continuing || read_but_dont_execute)
@@ -712,6 +720,10 @@ execute_command_internal (command, asynchronous, pipe_in, pipe_out,
 
   QUIT;
 
+  /* Expansion temporaries allocated while executing this command are
+     released when it completes. */
+  arena_scope = arena_mark ();
+
   switch (command->type)
     {
     case cm_simple:
@@ -958,6 +970,8 @@ execute_command_internal (command, asynchronous, pipe_in, pipe_out,
       command_error ("execute_command", CMDERR_BADTYPE, command->type, 0);
     }
 
+  arena_release (arena_scope);
+
   if (my_undo_list)
     {
       do_redirections (my_undo_list, RX_ACTIVE);
@@ -2572,7 +2586,12 @@ eval_arith_for_expr (l, okp)
   WORD_LIST *new;
   intmax_t expresult;
   int r;
+  size_t arena_scope;
 
+  /* The expressions are expanded once per iteration without going through
+     execute_command_internal, so release what each expansion allocates
+     here rather than when the whole loop completes. */
+  arena_scope = arena_mark ();
   new = expand_words_no_vars (l);
   if (new)
     {
@@ -2611,6 +2630,7 @@ eval_arith_for_expr (l, okp)
       if (okp)
 	*okp = 1;
     }
+  arena_release (arena_scope);
   return (expresult);
 }
 
@@ -3030,19 +3050,201 @@ execute_select_command (select_command)
 }
 #endif /* SELECT_COMMAND */
 
+/* Don't bother building a dispatch table for case commands with fewer
+   literal patterns than this. */
+#define CASE_DISPATCH_MIN	4
+
+/* Return non-zero if the case pattern W is a literal string: it has no
+   quoting, expansions, or pattern matching characters, so the only word
+   it can match is itself. */
+static int
+case_literal_pattern (w)
+     WORD_DESC *w;
+{
+  register char *s;
+
+  if (w == 0 || w->word == 0 || *w->word == '\0')
+    return 0;
+  for (s = w->word; *s; s++)
+    if (*s == CTLESC || *s == CTLNUL || strchr ("\\'\"$`*?[]()~|&;<> \t\n", *s))
+      return 0;
+  return 1;
+}
+
+/* Return the dispatch table for CASE_COMMAND, building it if necessary.
+   Returns NULL if it isn't worth using. */
+static CASE_DISPATCH *
+case_dispatch_table (case_command)
+     CASE_COM *case_command;
+{
+  CASE_DISPATCH *d;
+  PATTERN_LIST *clauses;
+  WORD_LIST *list;
+  BUCKET_CONTENTS *item;
+  int n, nlit, nbuckets, *ind;
+
+  d = case_command->dispatch;
+  if (d == 0 || d->nclauses >= 0)
+    return ((d && d->table) ? d : (CASE_DISPATCH *)NULL);
+
+  for (n = nlit = 0, clauses = case_command->clauses; clauses; clauses = clauses->next, n++)
+    {
+      for (list = clauses->patterns; list; list = list->next)
+	if (case_literal_pattern (list->word) == 0)
+	  break;
+      if (list == 0)
+	nlit += list_length (clauses->patterns);
+    }
+  d->nclauses = n;
+  if (nlit < CASE_DISPATCH_MIN)
+    return ((CASE_DISPATCH *)NULL);
+
+  d->nonlit = (int *)xmalloc (n * sizeof (int));
+  /* hashlib masks hash values with the bucket count, which must be a
+     power of two */
+  for (nbuckets = 16; nbuckets < nlit; nbuckets <<= 1)
+    ;
+  d->table = hash_create (nbuckets);
+
+  for (n = 0, clauses = case_command->clauses; clauses; clauses = clauses->next, n++)
+    {
+      for (list = clauses->patterns; list; list = list->next)
+	if (case_literal_pattern (list->word) == 0)
+	  break;
+      if (list)
+	{
+	  d->nonlit[d->nnonlit++] = n;
+	  continue;
+	}
+      /* Each entry in the table is the number of clauses with that
+	 literal pattern followed by their indices, in increasing order. */
+      for (list = clauses->patterns; list; list = list->next)
+	{
+	  item = hash_insert (list->word->word, d->table, 0);
+	  if (item->data == 0)
+	    {
+	      item->key = savestring (list->word->word);
+	      ind = (int *)xmalloc (2 * sizeof (int));
+	      ind[0] = 0;
+	    }
+	  else
+	    {
+	      ind = (int *)item->data;
+	      if (ind[ind[0]] == n)	/* same pattern twice in one clause */
+		continue;
+	      ind = (int *)xrealloc (ind, (ind[0] + 2) * sizeof (int));
+	    }
+	  ind[++ind[0]] = n;
+	  item->data = (PTR_T)ind;
+	}
+    }
+
+  return d;
+}
+
+/* Return non-zero if WORD matches one of the patterns in CLAUSE. */
+static int
+case_clause_matches (clause, word)
+     PATTERN_LIST *clause;
+     char *word;
+{
+  register WORD_LIST *list;
+  WORD_LIST *es;
+  char *pattern;
+  int match;
+
+  for (list = clause->patterns; list; list = list->next)
+    {
+      es = expand_word_leave_quoted (list->word, 0);
+
+      if (es && es->word && es->word->word && *(es->word->word))
+	pattern = quote_string_for_globbing (es->word->word, QGLOB_CVTNULL);
+      else
+	{
+	  pattern = (char *)xmalloc (1);
+	  pattern[0] = '\0';
+	}
+
+      /* Since the pattern does not undergo quote removal (as per
+	 Posix.2, section 3.9.4.3), the strmatch () call must be able
+	 to recognize backslashes as escape characters. */
+      match = strmatch (pattern, word, FNMATCH_EXTFLAG|FNMATCH_IGNCASE) != FNM_NOMATCH;
+      free (pattern);
+
+      dispose_words (es);
+
+      if (match)
+	return 1;
+
+      QUIT;
+    }
+  return 0;
+}
+
+/* Return the index of the first clause at or after START whose patterns
+   match WORD, or D->nclauses if there isn't one.  *CLAUSEP is the clause
+   at index START; it's left pointing to the clause at the returned index.
+   Only the clauses that aren't all literals and come before the first
+   literal match need their patterns expanded and tested, in order, as the
+   shell would. */
+static int
+case_dispatch_next (d, word, start, clausep)
+     CASE_DISPATCH *d;
+     char *word;
+     int start;
+     PATTERN_LIST **clausep;
+{
+  BUCKET_CONTENTS *item;
+  PATTERN_LIST *clauses;
+  int lit, i, *ind;
+
+  lit = d->nclauses;
+  if (item = hash_search (word, d->table, 0))
+    {
+      ind = (int *)item->data;
+      for (i = 1; i <= ind[0]; i++)
+	if (ind[i] >= start)
+	  {
+	    lit = ind[i];
+	    break;
+	  }
+    }
+
+  clauses = *clausep;
+  for (i = 0; i < d->nnonlit && d->nonlit[i] < lit; i++)
+    {
+      if (d->nonlit[i] < start)
+	continue;
+      for ( ; start < d->nonlit[i]; start++)
+	clauses = clauses->next;
+      if (case_clause_matches (clauses, word))
+	break;
+    }
+  if (i < d->nnonlit && d->nonlit[i] < lit)
+    lit = d->nonlit[i];
+  else
+    for ( ; clauses && start < lit; start++)
+      clauses = clauses->next;
+
+  *clausep = clauses;
+  return lit;
+}
+
 /* Execute a CASE command.  The syntax is: CASE word_desc IN pattern_list ESAC.
    The pattern_list is a linked list of pattern clauses; each clause contains
    some patterns to compare word_desc against, and an associated command to
-   execute. */
+   execute.  If enough of the patterns are literal strings, the clauses they
+   belong to are found using a hash table built the first time the command
+   is executed. */
 static int
 execute_case_command (case_command)
      CASE_COM *case_command;
 {
-  register WORD_LIST *list;
-  WORD_LIST *wlist, *es;
   PATTERN_LIST *clauses;
-  char *word, *pattern;
-  int retval, match, ignore_return, save_line_number;
+  CASE_DISPATCH *d;
+  WORD_LIST *wlist;
+  char *word;
+  int retval, ignore_return, save_line_number, i;
 
   save_line_number = line_number;
   line_number = case_command->line;
@@ -3086,46 +3288,49 @@ execute_case_command (case_command)
 
 #define EXIT_CASE()  goto exit_case_command
 
-  for (clauses = case_command->clauses; clauses; clauses = clauses->next)
+  /* Literal patterns can't match case-insensitively with a table lookup. */
+  d = match_ignore_case ? (CASE_DISPATCH *)NULL : case_dispatch_table (case_command);
+
+  if (d)
     {
-      QUIT;
-      for (list = clauses->patterns; list; list = list->next)
+      clauses = case_command->clauses;
+      for (i = 0; i < d->nclauses; i++, clauses = clauses->next)
 	{
-	  es = expand_word_leave_quoted (list->word, 0);
-
-	  if (es && es->word && es->word->word && *(es->word->word))
-	    pattern = quote_string_for_globbing (es->word->word, QGLOB_CVTNULL);
-	  else
-	    {
-	      pattern = (char *)xmalloc (1);
-	      pattern[0] = '\0';
-	    }
-
-	  /* Since the pattern does not undergo quote removal (as per
-	     Posix.2, section 3.9.4.3), the strmatch () call must be able
-	     to recognize backslashes as escape characters. */
-	  match = strmatch (pattern, word, FNMATCH_EXTFLAG|FNMATCH_IGNCASE) != FNM_NOMATCH;
-	  free (pattern);
-
-	  dispose_words (es);
+	  QUIT;
+	  i = case_dispatch_next (d, word, i, &clauses);
+	  if (i >= d->nclauses)
+	    break;
 
-	  if (match)
+	  for (;;)
 	    {
-	      do
-		{
-		  if (clauses->action && ignore_return)
-		    clauses->action->flags |= CMD_IGNORE_RETURN;
-		  retval = execute_command (clauses->action);
-		}
-	      while ((clauses->flags & CASEPAT_FALLTHROUGH) && (clauses = clauses->next));
-	      if (clauses == 0 || (clauses->flags & CASEPAT_TESTNEXT) == 0)
-		EXIT_CASE ();
-	      else
+	      if (clauses->action && ignore_return)
+		clauses->action->flags |= CMD_IGNORE_RETURN;
+	      retval = execute_command (clauses->action);
+	      if ((clauses->flags & CASEPAT_FALLTHROUGH) == 0 || (clauses = clauses->next) == 0)
 		break;
+	      i++;
 	    }
+	  if (clauses == 0 || (clauses->flags & CASEPAT_TESTNEXT) == 0)
+	    EXIT_CASE ();
+	}
+      EXIT_CASE ();
+    }
 
-	  QUIT;
+  for (clauses = case_command->clauses; clauses; clauses = clauses->next)
+    {
+      QUIT;
+      if (case_clause_matches (clauses, word) == 0)
+	continue;
+
+      do
+	{
+	  if (clauses->action && ignore_return)
+	    clauses->action->flags |= CMD_IGNORE_RETURN;
+	  retval = execute_command (clauses->action);
 	}
+      while ((clauses->flags & CASEPAT_FALLTHROUGH) && (clauses = clauses->next));
+      if (clauses == 0 || (clauses->flags & CASEPAT_TESTNEXT) == 0)
+	EXIT_CASE ();
     }
 
 exit_case_command:
@@ -3632,6 +3837,78 @@ fix_assignment_words (words)
       }
 }
 
+#if defined (ARRAY_VARS)
+/* Builtins that neither run commands nor assign variables.  Their
+   arguments can share the strings of the arrays they were expanded
+   from. */
+static char *borrowing_builtins[] = { "echo", "printf", "test", "[", (char *)NULL };
+
+/* Return non-zero if "${name[@]}" in the words of COMMAND may expand into
+   words that share the array's strings.  COMMAND has to run one of the
+   builtins above, and nothing else expanded for it may change an array
+   before it finishes, so the other words and the redirections can't
+   contain `$'.  printf is allowed only if its first argument is a quoted
+   format, so it can't be -v. */
+static int
+can_borrow_array_words (command)
+     SIMPLE_COM *command;
+{
+  WORD_LIST *w;
+  REDIRECT *r;
+  char *name, *s;
+  int i;
+
+  w = command->words;
+  if (w == 0 || (w->word->flags & (W_HASDOLLAR|W_QUOTED|W_ASSIGNMENT)))
+    return 0;
+
+  name = w->word->word;
+  for (i = 0; borrowing_builtins[i]; i++)
+    if (STREQ (name, borrowing_builtins[i]))
+      break;
+  if (borrowing_builtins[i] == 0 || find_function (name) || find_shell_builtin (name) == 0)
+    return 0;
+
+  if (name[0] == 'p')
+    {
+      if (w->next == 0 || (w->next->word->flags & W_HASDOLLAR))
+	return 0;
+      s = w->next->word->word;
+      if ((s[0] != '\'' && s[0] != '"') || s[1] == '\0' || s[1] == '-' ||
+	  s[1] == '\'' || s[1] == '"' || s[1] == '\\')
+	return 0;
+    }
+
+  for (w = w->next; w; w = w->next)
+    if ((w->word->flags & W_HASDOLLAR) && quoted_array_word_p (w->word) == 0)
+      return 0;
+
+  for (r = command->redirects; r; r = r->next)
+    {
+      if (r->rflags & REDIR_VARASSIGN)
+	return 0;
+      switch (r->instruction)
+	{
+	case r_duplicating_input:
+	case r_duplicating_output:
+	case r_close_this:
+	case r_move_input:
+	case r_move_output:
+	  break;
+	case r_reading_until:
+	case r_deblank_reading_until:
+	  return 0;
+	default:
+	  if (r->redirectee.filename->flags & W_HASDOLLAR)
+	    return 0;
+	  break;
+	}
+    }
+
+  return 1;
+}
+#endif
+
 /* Return 1 if the file found by searching $PATH for PATHNAME, defaulting
    to PATHNAME, is a directory.  Used by the autocd code below. */
 static int
@@ -3772,7 +4049,12 @@ execute_simple_command (simple_command, pipe_in, pipe_out, async, fds_to_close)
       /* Pass the ignore return flag down to command substitutions */
       if (simple_command->flags & CMD_IGNORE_RETURN)	/* XXX */
 	comsub_ignore_return++;
-      words = expand_words (simple_command->words);
+#if defined (ARRAY_VARS)
+      if (can_borrow_array_words (simple_command))
+	words = expand_words_borrow (simple_command->words);
+      else
+#endif
+	words = expand_words (simple_command->words);
       if (simple_command->flags & CMD_IGNORE_RETURN)
 	comsub_ignore_return--;
       current_fds_to_close = (struct fd_bitmap *)NULL;
@@ -4146,14 +4428,8 @@ execute_function (var, words, flags, fds_to_close, async, subshell)
   int return_val, result;
   COMMAND *tc, *fc, *save_current;
   char *debug_trap, *error_trap, *return_trap;
-#if defined (ARRAY_VARS)
-  SHELL_VAR *funcname_v, *nfv, *bash_source_v, *bash_lineno_v;
-  ARRAY *funcname_a;
-  volatile ARRAY *bash_source_a;
-  volatile ARRAY *bash_lineno_a;
-#endif
   FUNCTION_DEF *shell_fn;
-  char *sfile, *t;
+  char *sfile;
 
   USE_VAR(fc);
 
@@ -4164,12 +4440,6 @@ execute_function (var, words, flags, fds_to_close, async, subshell)
       jump_to_top_level (DISCARD);
     }
 
-#if defined (ARRAY_VARS)
-  GET_ARRAY_FROM_VAR ("FUNCNAME", funcname_v, funcname_a);
-  GET_ARRAY_FROM_VAR ("BASH_SOURCE", bash_source_v, bash_source_a);
-  GET_ARRAY_FROM_VAR ("BASH_LINENO", bash_lineno_v, bash_lineno_a);
-#endif
-
   tc = (COMMAND *)copy_command (function_cell (var));
   if (tc && (flags & CMD_IGNORE_RETURN))
     tc->flags |= CMD_IGNORE_RETURN;
@@ -4251,12 +4521,7 @@ execute_function (var, words, flags, fds_to_close, async, subshell)
   /* This is quite similar to the code in shell.c and elsewhere. */
   shell_fn = find_function_def (this_shell_function->name);
   sfile = shell_fn ? shell_fn->source_file : "";
-  array_push (funcname_a, this_shell_function->name);
-
-  array_push (bash_source_a, sfile);
-  t = itos (executing_line_number ());
-  array_push (bash_lineno_a, t);
-  free (t);
+  push_call_frame (this_shell_function->name, sfile, executing_line_number ());
 #endif
 
   /* The temporary environment for a function is supposed to apply to
@@ -4328,16 +4593,7 @@ execute_function (var, words, flags, fds_to_close, async, subshell)
     run_unwind_frame ("function_calling");
 
 #if defined (ARRAY_VARS)
-  /* These two variables cannot be unset, and cannot be affected by the
-     function. */
-  array_pop (bash_source_a);
-  array_pop (bash_lineno_a);
-
-  /* FUNCNAME can be unset, and so can potentially be changed by the
-     function. */
-  GET_ARRAY_FROM_VAR ("FUNCNAME", nfv, funcname_a);
-  if (nfv == funcname_v)
-    array_pop (funcname_a);
+  pop_call_frame ();
 #endif
   
   if (variable_context == 0 || this_shell_function == 0)
@@ -155,6 +155,12 @@ extern void show_shell_version __P((int));
 /* Functions from the bash library, lib/sh/libsh.a.  These should really
    go into a separate include file. */
 
+/* declarations for functions defined in lib/sh/arena.c */
+extern PTR_T arena_alloc __P((size_t));
+extern void arena_free __P((PTR_T));
+extern size_t arena_mark __P((void));
+extern void arena_release __P((size_t));
+
 /* declarations for functions defined in lib/sh/casemod.c */
 extern char *sh_modcase __P((const char *, char *, int));
 
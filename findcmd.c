@@ -350,10 +350,14 @@ search_for_command (pathname)
 	  command = find_user_command_in_path (pathname, value_cell (path),
 					       FS_EXEC_PREFERRED|FS_NODIRS);
 	}
+      else if (phash_miss_search (pathname))
+	command = (char *)NULL;
       else
 	command = find_user_command (pathname);
       if (command && hashing_enabled && temp_path == 0)
 	phash_insert ((char *)pathname, command, dot_found_in_search, 1);	/* XXX fix const later */
+      else if (command == 0 && hashing_enabled && temp_path == 0)
+	phash_miss_insert (pathname);
     }
   return (command);
 }
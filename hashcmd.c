@@ -23,6 +23,7 @@
 
 #include "bashtypes.h"
 #include "posixstat.h"
+#include "posixtime.h"
 
 #if defined (HAVE_UNISTD_H)
 #  include <unistd.h>
@@ -31,6 +32,7 @@
 #include "bashansi.h"
 
 #include "shell.h"
+#include "jobs.h"
 #include "findcmd.h"
 #include "hashcmd.h"
 
@@ -38,7 +40,32 @@ extern int hashing_enabled;
 
 HASH_TABLE *hashed_filenames = (HASH_TABLE *)NULL;
 
+/* The negative cache: names of commands we looked for in $PATH and did
+   not find.  It is only trusted while none of the directories in $PATH
+   have changed since the misses were recorded. */
+HASH_TABLE *hashed_misses = (HASH_TABLE *)NULL;
+
+typedef struct _pathstamp {
+  char *dir;
+  time_t mtime;		/* (time_t)-1 if the directory does not exist */
+} PATH_STAMP;
+
+static PATH_STAMP *miss_dirs;
+static int miss_ndirs;
+
+/* When the $PATH directories were last checked against MISS_DIRS, and the
+   last child we had created at that point.  Within the same second, and
+   as long as we haven't forked anything that could have installed a new
+   command, the directories don't need to be checked again.  When the
+   shell creates a file itself, phash_miss_expire forces the next check. */
+static time_t miss_checked;
+static pid_t miss_lastpid;
+
 static void phash_freedata __P((PTR_T));
+static int phash_miss_usable __P((const char *));
+static time_t phash_dirstamp __P((char *));
+static int phash_miss_snapshot __P((void));
+static int phash_miss_valid __P((void));
 
 void
 phash_create ()
@@ -60,6 +87,7 @@ phash_flush ()
 {
   if (hashed_filenames)
     hash_flush (hashed_filenames, phash_freedata);
+  phash_miss_flush ();
 }
 
 /* Remove FILENAME from the table of hashed commands. */
@@ -78,7 +106,7 @@ phash_remove (filename)
       if (item->data)
 	phash_freedata (item->data);
       free (item->key);
-      free (item);
+      hash_free_item (item);
       return 0;
     }
   return 1;
@@ -102,6 +130,9 @@ phash_insert (filename, full_path, check_dot, found)
   if (hashed_filenames == 0)
     phash_create ();
 
+  if (hashed_misses)
+    phash_miss_remove (filename);
+
   item = hash_insert (filename, hashed_filenames, 0);
   if (item->data)
     free (pathdata(item)->path);
@@ -194,3 +225,187 @@ phash_search (filename)
 
   return (savestring (path));
 }
+
+/* Functions to manage the negative cache. */
+
+/* Misses are only recorded for names that are looked up in the permanent
+   value of $PATH. */
+static int
+phash_miss_usable (filename)
+     const char *filename;
+{
+  SHELL_VAR *v;
+
+  if (hashing_enabled == 0 || absolute_program (filename))
+    return 0;
+  v = find_variable_internal ("PATH", 1);
+  return (v == 0 || tempvar_p (v) == 0);
+}
+
+static time_t
+phash_dirstamp (dir)
+     char *dir;
+{
+  struct stat sb;
+
+  return ((stat (dir, &sb) < 0) ? (time_t)-1 : sb.st_mtime);
+}
+
+/* Record the modification times of the directories in $PATH.  Returns 0
+   if the current value of $PATH can't be used for the negative cache:
+   it contains a relative directory, whose contents change with the
+   current directory, or a directory modified during the current second,
+   which might be modified again without changing its timestamp. */
+static int
+phash_miss_snapshot ()
+{
+  char *path_list, *dir;
+  int path_index, nalloc;
+  time_t now;
+
+  path_list = get_string_value ("PATH");
+  if (path_list == 0 || *path_list == '\0')
+    return 0;
+
+  now = NOW;
+  nalloc = miss_ndirs = 0;
+  path_index = 0;
+  while (path_list[path_index])
+    {
+      dir = extract_colon_unit (path_list, &path_index);
+      if (dir == 0)
+	break;
+      if (ABSPATH (dir) == 0)
+	{
+	  free (dir);
+	  return 0;
+	}
+      if (miss_ndirs >= nalloc)
+	miss_dirs = (PATH_STAMP *)xrealloc (miss_dirs, (nalloc += 8) * sizeof (PATH_STAMP));
+      miss_dirs[miss_ndirs].dir = dir;
+      miss_dirs[miss_ndirs].mtime = phash_dirstamp (dir);
+      if (miss_dirs[miss_ndirs++].mtime >= now)
+	return 0;
+    }
+
+  miss_checked = now;
+  miss_lastpid = last_made_pid;
+  return 1;
+}
+
+/* Return non-zero if none of the directories in $PATH changed since the
+   negative cache was created. */
+static int
+phash_miss_valid ()
+{
+  register int i;
+  time_t now;
+
+  now = NOW;
+  if (now == miss_checked && last_made_pid == miss_lastpid)
+    return 1;
+
+  for (i = 0; i < miss_ndirs; i++)
+    if (phash_dirstamp (miss_dirs[i].dir) != miss_dirs[i].mtime)
+      return 0;
+
+  miss_checked = now;
+  miss_lastpid = last_made_pid;
+  return 1;
+}
+
+/* The shell has created a file, possibly in one of the $PATH directories;
+   check them again before trusting the negative cache. */
+void
+phash_miss_expire ()
+{
+  miss_checked = 0;
+}
+
+void
+phash_miss_flush ()
+{
+  register int i;
+
+  if (hashed_misses)
+    {
+      hash_flush (hashed_misses, 0);
+      hash_dispose (hashed_misses);
+      hashed_misses = (HASH_TABLE *)NULL;
+    }
+  for (i = 0; i < miss_ndirs; i++)
+    free (miss_dirs[i].dir);
+  FREE (miss_dirs);
+  miss_dirs = (PATH_STAMP *)NULL;
+  miss_ndirs = 0;
+}
+
+/* Remember that FILENAME could not be found in $PATH. */
+void
+phash_miss_insert (filename)
+     const char *filename;
+{
+  register BUCKET_CONTENTS *item;
+
+  if (phash_miss_usable (filename) == 0)
+    return;
+
+  if (hashed_misses == 0)
+    {
+      if (phash_miss_snapshot () == 0)
+	{
+	  phash_miss_flush ();
+	  return;
+	}
+      hashed_misses = hash_create (FILENAME_HASH_BUCKETS);
+    }
+  else if (HASH_ENTRIES (hashed_misses) >= MISSES_HASH_MAX)
+    {
+      /* Don't let a long interactive session full of typos grow the
+	 cache without bound. */
+      phash_miss_flush ();
+      phash_miss_insert (filename);
+      return;
+    }
+
+  item = hash_insert ((char *)filename, hashed_misses, 0);
+  if (item->key == filename)
+    item->key = savestring (filename);
+}
+
+int
+phash_miss_remove (filename)
+     const char *filename;
+{
+  register BUCKET_CONTENTS *item;
+
+  if (hashed_misses == 0)
+    return 1;
+
+  item = hash_remove (filename, hashed_misses, 0);
+  if (item)
+    {
+      free (item->key);
+      free (item);
+      return 0;
+    }
+  return 1;
+}
+
+/* Return non-zero if FILENAME is known not to be in any directory in
+   $PATH, so the caller can skip searching for it. */
+int
+phash_miss_search (filename)
+     const char *filename;
+{
+  if (hashed_misses == 0 || phash_miss_usable (filename) == 0)
+    return 0;
+
+  if (phash_miss_valid () == 0)
+    {
+      phash_miss_flush ();
+      return 0;
+    }
+
+  return (hash_search (filename, hashed_misses, 0) != 0);
+}
@@ -22,8 +22,10 @@
 #include "hashlib.h"
 
 #define FILENAME_HASH_BUCKETS 64	/* must be power of two */
+#define MISSES_HASH_MAX 256	/* flush the negative cache past this size */
 
 extern HASH_TABLE *hashed_filenames;
+extern HASH_TABLE *hashed_misses;
 
 typedef struct _pathdata {
   char *path;		/* The full pathname of the file. */
@@ -41,3 +43,9 @@ extern void phash_flush __P((void));
 extern void phash_insert __P((char *, char *, int, int));
 extern int phash_remove __P((const char *));
 extern char *phash_search __P((const char *));
+
+extern void phash_miss_flush __P((void));
+extern void phash_miss_expire __P((void));
+extern void phash_miss_insert __P((const char *));
+extern int phash_miss_remove __P((const char *));
+extern int phash_miss_search __P((const char *));
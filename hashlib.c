@@ -40,6 +40,13 @@
 
 static BUCKET_CONTENTS *copy_bucket_array __P((BUCKET_CONTENTS *, sh_string_func_t *));
 
+/* Freed buckets, kept for reuse.  Local variables and associative array
+   elements are inserted and flushed in bulk. */
+static sh_obj_cache_t bucketcache = {0, 0, 0};
+
+#define BUCKETCACHESIZE	64
+#define BUCKETCACHEMAX	4096
+
 /* Make a new hash table with BUCKETS number of buckets.  Initialize
    each slot in the table to NULL. */
 HASH_TABLE *
@@ -49,6 +56,9 @@ hash_create (buckets)
   HASH_TABLE *new_table;
   register int i;
 
+  if (bucketcache.data == 0)
+    ocache_create_growable (bucketcache, BUCKET_CONTENTS, BUCKETCACHESIZE, BUCKETCACHEMAX, "bucket");
+
   new_table = (HASH_TABLE *)xmalloc (sizeof (HASH_TABLE));
   if (buckets == 0)
     buckets = DEFAULT_HASH_BUCKETS;
@@ -85,12 +95,12 @@ copy_bucket_array (ba, cpdata)
     {
       if (n == 0)
         {
-          new_bucket = (BUCKET_CONTENTS *)xmalloc (sizeof (BUCKET_CONTENTS));
+          ocache_alloc (bucketcache, BUCKET_CONTENTS, new_bucket);
           n = new_bucket;
         }
       else
         {
-          n->next = (BUCKET_CONTENTS *)xmalloc (sizeof (BUCKET_CONTENTS));
+          ocache_alloc (bucketcache, BUCKET_CONTENTS, n->next);
           n = n->next;
         }
 
@@ -188,7 +198,7 @@ hash_search (string, table, flags)
 
   if (flags & HASH_CREATE)
     {
-      list = (BUCKET_CONTENTS *)xmalloc (sizeof (BUCKET_CONTENTS));
+      ocache_alloc (bucketcache, BUCKET_CONTENTS, list);
       list->next = table->bucket_array[bucket];
       table->bucket_array[bucket] = list;
 
@@ -239,6 +249,15 @@ hash_remove (string, table, flags)
   return ((BUCKET_CONTENTS *) NULL);
 }
 
+/* Dispose of ITEM, which hash_remove has taken out of its table, after the
+   caller has freed its key and data. */
+void
+hash_free_item (item)
+     BUCKET_CONTENTS *item;
+{
+  ocache_free (bucketcache, BUCKET_CONTENTS, item);
+}
+
 /* Create an entry for STRING, in TABLE.  If the entry already
    exists, then return it (unless the HASH_NOSRCH flag is set). */
 BUCKET_CONTENTS *
@@ -261,7 +280,7 @@ hash_insert (string, table, flags)
     {
       bucket = HASH_BUCKET (string, table, hv);
 
-      item = (BUCKET_CONTENTS *)xmalloc (sizeof (BUCKET_CONTENTS));
+      ocache_alloc (bucketcache, BUCKET_CONTENTS, item);
       item->next = table->bucket_array[bucket];
       table->bucket_array[bucket] = item;
 
@@ -304,7 +323,7 @@ hash_flush (table, free_data)
 	  else
 	    free (item->data);
 	  free (item->key);
-	  free (item);
+	  ocache_free (bucketcache, BUCKET_CONTENTS, item);
 	}
       table->bucket_array[i] = (BUCKET_CONTENTS *)NULL;
     }
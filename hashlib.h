@@ -62,6 +62,7 @@ extern int hash_size __P((HASH_TABLE *));
 extern BUCKET_CONTENTS *hash_search __P((const char *, HASH_TABLE *, int));
 extern BUCKET_CONTENTS *hash_insert __P((char *, HASH_TABLE *, int));
 extern BUCKET_CONTENTS *hash_remove __P((const char *, HASH_TABLE *, int));
+extern void hash_free_item __P((BUCKET_CONTENTS *));
 
 /* Miscellaneous */
 extern unsigned int hash_string __P((const char *));
@@ -56,16 +56,38 @@ typedef struct objcache {
 	PTR_T	data;
 	int	cs;		/* cache size, number of objects */
 	int	nc;		/* number of cache entries */
+	int	mincs;		/* ocache_shrink never goes below this */
+	int	maxcs;		/* cache may grow to this size */
+	const char *name;	/* for reporting statistics */
+	unsigned long nalloc;	/* objects allocated */
+	unsigned long nhit;	/* allocations satisfied from the cache */
+	unsigned long nfree;	/* objects freed */
+	unsigned long nspill;	/* frees that found the cache full */
+	struct objcache *next;	/* list of registered caches */
 } sh_obj_cache_t;
 
 /* Create an object cache C of N pointers to OTYPE. */
 #define ocache_create(c, otype, n) \
 	do { \
 		(c).data = xmalloc((n) * sizeof (otype *)); \
-		(c).cs = (n); \
+		(c).cs = (c).mincs = (c).maxcs = (n); \
 		(c).nc = 0; \
 	} while (0)
 
+/*
+ * Create an object cache C of N pointers to OTYPE that doubles in size,
+ * up to MAX objects, when an object is freed while it is full, and
+ * register it under NAME so ocache_trim can shrink it and its statistics
+ * can be reported.
+ */
+#define ocache_create_growable(c, otype, n, max, cname) \
+	do { \
+		ocache_create (c, otype, n); \
+		(c).maxcs = (max); \
+		(c).name = (cname); \
+		ocache_register (&(c)); \
+	} while (0)
+
 /* Destroy an object cache C. */
 #define ocache_destroy(c) \
 	do { \
@@ -89,7 +111,9 @@ typedef struct objcache {
  */
 #define ocache_alloc(c, otype, r) \
 	do { \
+		(c).nalloc++; \
 		if ((c).nc > 0) { \
+			(c).nhit++; \
 			(r) = (otype *)((otype **)((c).data))[--(c).nc]; \
 		} else \
 			(r) = (otype *)xmalloc (sizeof (otype)); \
@@ -97,18 +121,44 @@ typedef struct objcache {
 
 /*
  * Free an item R of type pointer to OTYPE, adding to object cache C if
- * there is room and calling xfree if the cache is full.  If R is added
- * to the object cache, the contents are scrambled.
+ * there is room and calling xfree if the cache is full and cannot grow.
+ * If R is added to the object cache, the contents are scrambled.
  */
 #define ocache_free(c, otype, r) \
 	do { \
+		(c).nfree++; \
+		if ((c).nc == (c).cs && (c).cs < (c).maxcs) { \
+			(c).cs = ((c).cs * 2 < (c).maxcs) ? (c).cs * 2 : (c).maxcs; \
+			(c).data = xrealloc ((c).data, (c).cs * sizeof (otype *)); \
+		} \
 		if ((c).nc < (c).cs) { \
 			OC_MEMSET ((r), 0xdf, sizeof(otype)); \
 			((otype **)((c).data))[(c).nc++] = (r); \
-		} else \
+		} else { \
+			(c).nspill++; \
 			xfree (r); \
+		} \
+	} while (0)
+
+/*
+ * Free cached items in object cache C until at most N remain, and give
+ * back the space the cache grew into beyond N.
+ */
+#define ocache_shrink(c, n) \
+	do { \
+		while ((c).nc > (n)) \
+			xfree (((PTR_T *)((c).data))[--(c).nc]); \
+		if ((c).cs > (n) && (c).cs > (c).mincs) { \
+			(c).cs = ((n) > (c).mincs) ? (n) : (c).mincs; \
+			(c).data = xrealloc ((c).data, (c).cs * sizeof (PTR_T)); \
+		} \
 	} while (0)
 
+/* Defined in lib/sh/ocache.c */
+extern void ocache_register __P((sh_obj_cache_t *));
+extern void ocache_trim __P((void));
+extern sh_obj_cache_t *ocache_list __P((void));
+
 /*
  * One may declare and use an object cache as (for instance):
  *
@@ -127,6 +177,12 @@ typedef struct objcache {
  *	ocache_free(wdcache, WORD_DESC, wd);
  *	ocache_free(wlcache, WORD_LIST, wl);
  *
+ * A cache that should absorb bursts of frees, such as the variables
+ * disposed of when a function with many locals returns, can be created
+ * with ocache_create_growable instead:
+ *
+ *	ocache_create_growable (vcache, SHELL_VAR, 32, 1024, "variable");
+ *
  * The use is almost arbitrary.
  */
 
@@ -58,4 +58,15 @@
 #  define REAL_DIR_ENTRY(dp) (dp->d_ino != 0)
 #endif /* _POSIX_SOURCE */
 
+/* Systems that record the file type in the directory entry let us tell
+   directories from other files without a stat(2).  DT_UNKNOWN means the
+   file system didn't tell us. */
+#if defined (HAVE_DIRENT_H) && defined (DT_UNKNOWN) && defined (DT_DIR) && defined (DT_LNK)
+#  define D_TYPE_KNOWN(dp)	((dp)->d_type != DT_UNKNOWN && (dp)->d_type != DT_LNK)
+#  define D_TYPE_ISDIR(dp)	((dp)->d_type == DT_DIR)
+#else
+#  define D_TYPE_KNOWN(dp)	0
+#  define D_TYPE_ISDIR(dp)	0
+#endif
+
 #endif /* !_POSIXDIR_H_ */
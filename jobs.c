@@ -162,11 +162,53 @@ extern WORD_LIST *subst_assign_varlist;
 static struct jobstats zerojs = { -1L, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, NO_JOB, NO_JOB, 0, 0 };
 struct jobstats js = { -1L, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, NO_JOB, NO_JOB, 0, 0 };
 
-struct bgpids bgpids = { 0, 0, 0 };
+struct bgpids bgpids = { 0, 0, 0, 0, 0, 0 };
+
+/* Hash table of indices into bgpids.storage, bucketed by pid. */
+static ps_index_t *pidstat_table = (ps_index_t *)NULL;
+static int pidstat_tablesize;
+
+#define PIDSTAT_BUCKET(pid)	((unsigned long)(pid) & (pidstat_tablesize - 1))
+
+/* The number of saved statuses bgpids.storage starts out holding. */
+#define BGPIDS_INITIAL	64
 
 /* The array of known jobs. */
 JOB **jobs = (JOB **)NULL;
 
+/* Freed PROCESS and JOB structs, kept for the next pipeline.  SIGCHLD is
+   blocked whenever they're allocated or freed. */
+static sh_obj_cache_t proccache = {0, 0, 0};
+static sh_obj_cache_t jobcache = {0, 0, 0};
+
+#define PROCCACHESIZE	16
+#define PROCCACHEMAX	256
+#define JOBCACHESIZE	8
+#define JOBCACHEMAX	64
+
+/* A hash table mapping the pids of the processes in the jobs array to
+   those processes and the jobs containing them, so that reaping a child
+   doesn't have to search every process in every job.  More than one
+   process may have the same pid if the system recycles pids; find_job
+   chooses among them. */
+struct pidhash_entry
+{
+  struct pidhash_entry *next;
+  PROCESS *proc;
+  int job;
+};
+
+static struct pidhash_entry **pidhash = (struct pidhash_entry **)NULL;
+static int pidhash_size, pidhash_count;
+
+#define PIDHASH_INITIAL	64
+
+/* pids are allocated sequentially, so the low bits are spread well enough */
+#define PIDHASH_BUCKET(pid)	((unsigned long)(pid) & (pidhash_size - 1))
+
+/* Finished background jobs not yet waited for, oldest first. */
+static JOB *jdone_head, *jdone_tail;
+
 #if 0
 /* The number of slots currently allocated to JOBS. */
 int job_slots = 0;
@@ -247,6 +289,15 @@ static int job_last_stopped __P((int));
 static int job_last_running __P((int));
 static int most_recent_job_in_state __P((int, JOB_STATE));
 static int find_job __P((pid_t, int, PROCESS **));
+static void pidhash_add __P((PROCESS *, int));
+static void pidhash_add_job __P((int));
+static void pidhash_remove __P((PROCESS *));
+static void pidhash_remove_job __P((JOB *));
+static void pidhash_set_job __P((JOB *, int));
+static void pidhash_flush __P((void));
+static int pidhash_proc_job __P((PROCESS *));
+static void jdone_add __P((JOB *));
+static void jdone_remove __P((JOB *));
 static int print_job __P((JOB *, int, int, int));
 static int process_exit_status __P((WAIT));
 static int process_exit_signal __P((WAIT));
@@ -277,12 +328,15 @@ static void restore_sigint_handler __P((void));
 static void pipe_read __P((int *));
 #endif
 
-static struct pidstat *bgp_alloc __P((pid_t, int));
-static struct pidstat *bgp_add __P((pid_t, int));
+static ps_index_t bgp_getindex __P((pid_t));
+static void bgp_link __P((ps_index_t));
+static void bgp_remove __P((ps_index_t));
+static void bgp_resize __P((void));
+static void bgp_trim __P((void));
+static void bgp_add __P((pid_t, int));
 static int bgp_delete __P((pid_t));
 static void bgp_clear __P((void));
 static int bgp_search __P((pid_t));
-static void bgp_prune __P((void));
 
 #if defined (ARRAY_VARS)
 static int *pstatuses;		/* list of pipeline statuses */
@@ -556,7 +610,7 @@ stop_pipeline (async, deferred)
       register PROCESS *p;
       int any_running, any_stopped, n;
 
-      newjob = (JOB *)xmalloc (sizeof (JOB));
+      ocache_alloc (jobcache, JOB, newjob);
 
       for (n = 1, p = the_pipeline; p->next != the_pipeline; n++, p = p->next)
 	;
@@ -593,8 +647,10 @@ stop_pipeline (async, deferred)
 
       newjob->j_cleanup = (sh_vptrfunc_t *)NULL;
       newjob->cleanarg = (PTR_T) NULL;
+      newjob->done_next = newjob->done_prev = (JOB *)NULL;
 
       jobs[i] = newjob;
+      pidhash_add_job (i);
       if (newjob->state == JDEAD && (newjob->flags & J_FOREGROUND))
 	setjstatus (i);
       if (newjob->state == JDEAD)
@@ -620,6 +676,8 @@ stop_pipeline (async, deferred)
 	  newjob->flags &= ~J_FOREGROUND;
 	  newjob->flags |= J_ASYNC;
 	  js.j_lastasync = newjob;
+	  if (newjob->state == JDEAD)
+	    jdone_add (newjob);
 	}
       reset_current ();
     }
@@ -651,82 +709,173 @@ stop_pipeline (async, deferred)
 }
 
 /* Functions to manage the list of exited background pids whose status has
-   been saved. */
-
-static struct pidstat *
-bgp_alloc (pid, status)
+   been saved.  bgpids.storage keeps them in the order they were saved, so
+   the oldest can be dropped once we have js.c_childmax of them, and
+   pidstat_table finds them by pid. */
+
+/* Return the index in bgpids.storage of the saved status for PID, or
+   NO_PIDSTAT. */
+static ps_index_t
+bgp_getindex (pid)
      pid_t pid;
-     int status;
+{
+  ps_index_t i;
+
+  if (pidstat_table == 0)
+    return NO_PIDSTAT;
+  for (i = pidstat_table[PIDSTAT_BUCKET (pid)]; i != NO_PIDSTAT; i = bgpids.storage[i].bucket_next)
+    if (bgpids.storage[i].pid == pid)
+      return i;
+  return NO_PIDSTAT;
+}
+
+/* Link slot I, which holds a saved status, into its hash bucket. */
+static void
+bgp_link (i)
+     ps_index_t i;
 {
   struct pidstat *ps;
+  ps_index_t *bucket;
+
+  ps = &bgpids.storage[i];
+  bucket = &pidstat_table[PIDSTAT_BUCKET (ps->pid)];
+  ps->bucket_prev = NO_PIDSTAT;
+  ps->bucket_next = *bucket;
+  if (*bucket != NO_PIDSTAT)
+    bgpids.storage[*bucket].bucket_prev = i;
+  *bucket = i;
+}
 
-  ps = (struct pidstat *)xmalloc (sizeof (struct pidstat));
-  ps->pid = pid;
-  ps->status = status;
-  ps->next = (struct pidstat *)0;
-  return ps;
+/* Remove the saved status in slot I and mark the slot free. */
+static void
+bgp_remove (i)
+     ps_index_t i;
+{
+  struct pidstat *ps;
+
+  ps = &bgpids.storage[i];
+  if (ps->bucket_prev != NO_PIDSTAT)
+    bgpids.storage[ps->bucket_prev].bucket_next = ps->bucket_next;
+  else
+    pidstat_table[PIDSTAT_BUCKET (ps->pid)] = ps->bucket_next;
+  if (ps->bucket_next != NO_PIDSTAT)
+    bgpids.storage[ps->bucket_next].bucket_prev = ps->bucket_prev;
+
+  ps->pid = NO_PID;
+  ps->bucket_next = ps->bucket_prev = NO_PIDSTAT;
+  bgpids.npid--;
+}
+
+/* Compact the saved statuses, oldest first, into a buffer with room for
+   as many again, so that filling it up costs a constant amount of work per
+   status saved.  The hash table is rebuilt to match the new size. */
+static void
+bgp_resize ()
+{
+  struct pidstat *nstorage;
+  ps_index_t nsize, i, n;
+  int tsize;
+
+  nsize = 2 * (bgpids.npid + 1);
+  if (nsize < BGPIDS_INITIAL)
+    nsize = BGPIDS_INITIAL;
+
+  nstorage = (struct pidstat *)xmalloc (nsize * sizeof (struct pidstat));
+  for (i = n = 0; i < bgpids.nused; i++)
+    {
+      struct pidstat *ps;
+
+      ps = &bgpids.storage[(bgpids.tail + i) % bgpids.nalloc];
+      if (ps->pid != NO_PID)
+	nstorage[n++] = *ps;
+    }
+  bgpids.tail = 0;
+  bgpids.head = bgpids.nused = n;
+  for ( ; n < nsize; n++)
+    nstorage[n].pid = NO_PID;
+
+  FREE (bgpids.storage);
+  bgpids.storage = nstorage;
+  bgpids.nalloc = nsize;
+
+  for (tsize = 16; tsize < nsize; tsize <<= 1)
+    ;
+  if (tsize != pidstat_tablesize)
+    {
+      FREE (pidstat_table);
+      pidstat_table = (ps_index_t *)xmalloc (tsize * sizeof (ps_index_t));
+      pidstat_tablesize = tsize;
+    }
+  for (i = 0; i < pidstat_tablesize; i++)
+    pidstat_table[i] = NO_PIDSTAT;
+  for (i = 0; i < bgpids.head; i++)
+    bgp_link (i);
 }
 
-static struct pidstat *
+/* Move bgpids.tail past the free slots left by deleted statuses. */
+static void
+bgp_trim ()
+{
+  while (bgpids.nused > 0 && bgpids.storage[bgpids.tail].pid == NO_PID)
+    {
+      bgpids.tail = (bgpids.tail + 1) % bgpids.nalloc;
+      bgpids.nused--;
+    }
+}
+
+/* Save STATUS as the exit status of background pid PID, replacing any
+   status already saved for it. */
+static void
 bgp_add (pid, status)
      pid_t pid;
      int status;
 {
+  ps_index_t i;
   struct pidstat *ps;
 
-  ps = bgp_alloc (pid, status);
+  if (js.c_childmax <= 0)
+    return;
 
-  if (bgpids.list == 0)
-    {
-      bgpids.list = bgpids.end = ps;
-      bgpids.npid = 0;			/* just to make sure */
-    }
-  else
+  if ((i = bgp_getindex (pid)) != NO_PIDSTAT)
+    bgp_remove (i);
+
+  /* Posix says to remember the statuses of the last CHILD_MAX
+     background pids, so drop the oldest once we have that many. */
+  bgp_trim ();
+  if (bgpids.npid >= js.c_childmax)
     {
-      bgpids.end->next = ps;
-      bgpids.end = ps;
+      bgp_remove (bgpids.tail);
+      bgp_trim ();
     }
-  bgpids.npid++;
 
-  if (bgpids.npid > js.c_childmax)
-    bgp_prune ();
+  if (bgpids.nused == bgpids.nalloc)
+    bgp_resize ();
+
+  i = bgpids.head;
+  ps = &bgpids.storage[i];
+  ps->pid = pid;
+  ps->status = status;
+  bgp_link (i);
+  bgpids.npid++;
 
-  return ps;
+  bgpids.head = (i + 1) % bgpids.nalloc;
+  bgpids.nused++;
 }
 
 static int
 bgp_delete (pid)
      pid_t pid;
 {
-  struct pidstat *prev, *p;
-
-  for (prev = p = bgpids.list; p; prev = p, p = p->next)
-    if (p->pid == pid)
-      {
-	prev->next = p->next;	/* remove from list */
-	break;
-      }
+  ps_index_t i;
 
-  if (p == 0)
+  if ((i = bgp_getindex (pid)) == NO_PIDSTAT)
     return 0;		/* not found */
 
 #if defined (DEBUG)
   itrace("bgp_delete: deleting %d", pid);
 #endif
 
-  /* Housekeeping in the border cases. */
-  if (p == bgpids.list)
-    bgpids.list = bgpids.list->next;
-  else if (p == bgpids.end)
-    bgpids.end = prev;
-
-  bgpids.npid--;
-  if (bgpids.npid == 0)
-    bgpids.list = bgpids.end = 0;
-  else if (bgpids.npid == 1)
-    bgpids.end = bgpids.list;		/* just to make sure */
-
-  free (p);
+  bgp_remove (i);
   return 1;
 }
 
@@ -734,16 +883,13 @@ bgp_delete (pid)
 static void
 bgp_clear ()
 {
-  struct pidstat *ps, *p;
-
-  for (ps = bgpids.list; ps; )
-    {
-      p = ps;
-      ps = ps->next;
-      free (p);
-    }
-  bgpids.list = bgpids.end = 0;
+  FREE (bgpids.storage);
+  FREE (pidstat_table);
+  bgpids.storage = (struct pidstat *)0;
+  pidstat_table = (ps_index_t *)0;
+  bgpids.head = bgpids.tail = bgpids.nused = bgpids.nalloc = 0;
   bgpids.npid = 0;
+  pidstat_tablesize = 0;
 }
 
 /* Search for PID in the list of saved background pids; return its status if
@@ -752,26 +898,10 @@ static int
 bgp_search (pid)
      pid_t pid;
 {
-  struct pidstat *ps;
+  ps_index_t i;
 
-  for (ps = bgpids.list ; ps; ps = ps->next)
-    if (ps->pid == pid)
-      return ps->status;
-  return -1;
-}
-
-static void
-bgp_prune ()
-{
-  struct pidstat *ps;
-
-  while (bgpids.npid > js.c_childmax)
-    {
-      ps = bgpids.list;
-      bgpids.list = bgpids.list->next;
-      free (ps);
-      bgpids.npid--;
-    }
+  i = bgp_getindex (pid);
+  return (i != NO_PIDSTAT ? bgpids.storage[i].status : -1);
 }
 
 /* Reset the values of js.j_lastj and js.j_firstj after one or both have
@@ -888,7 +1018,12 @@ delete_old_job (pid)
 	{
 	  internal_warning (_("forked pid %d appears in running job %d"), pid, job);
 	  if (p)
-	    p->pid = 0;
+	    {
+	      /* Keep the pid hash table bucketed by the new pid. */
+	      pidhash_remove (p);
+	      p->pid = 0;
+	      pidhash_add (p, job);
+	    }
 	}
     }
 }
@@ -921,6 +1056,8 @@ realloc_jobs_list ()
 	  ncur = j;
 	if (i == js.j_previous)
 	  nprev = j;
+	if (i != j)
+	  pidhash_set_job (jobs[i], j);
 	nlist[j++] = jobs[i];
 	if (jobs[i]->state == JDEAD)
 	  {
@@ -1024,6 +1161,9 @@ delete_job (job_index, dflags)
     js.j_lastasync = 0;
 
   free (temp->wd);
+  pidhash_remove_job (temp);
+  if (temp->flags & J_WAITDONE)
+    jdone_remove (temp);
   ndel = discard_pipeline (temp->pipe);
 
   js.c_injobs -= ndel;
@@ -1043,7 +1183,7 @@ delete_job (job_index, dflags)
   if (temp->deferred)
     dispose_command (temp->deferred);
 
-  free (temp);
+  ocache_free (jobcache, JOB, temp);
 
   js.j_njobs--;
   if (js.j_njobs == 0)
@@ -1083,7 +1223,7 @@ discard_pipeline (chain)
     {
       next = this->next;
       FREE (this->command);
-      free (this);
+      ocache_free (proccache, PROCESS, this);
       n++;
       this = next;
     }
@@ -1117,7 +1257,7 @@ add_process (name, pid)
     }
 #endif
 
-  t = (PROCESS *)xmalloc (sizeof (PROCESS));
+  ocache_alloc (proccache, PROCESS, t);
   t->next = the_pipeline;
   t->pid = pid;
   WSTATUS (t->status) = 0;
@@ -1146,8 +1286,9 @@ append_process (name, pid, status, jid)
      int jid;
 {
   PROCESS *t, *p;
+  sigset_t set, oset;
 
-  t = (PROCESS *)xmalloc (sizeof (PROCESS));
+  ocache_alloc (proccache, PROCESS, t);
   t->next = (PROCESS *)NULL;
   t->pid = pid;
   /* set process exit status using offset discovered by configure */
@@ -1161,6 +1302,10 @@ append_process (name, pid, status, jid)
     ;
   p->next = t;
   t->next = jobs[jid]->pipe;
+
+  BLOCK_CHILD (set, oset);
+  pidhash_add (t, jid);
+  UNBLOCK_CHILD (oset);
 }
 
 #if 0
@@ -1349,46 +1494,225 @@ find_process (pid, alive_only, jobp)
   return p;
 }
 
+/* Add the process P in job JOB to the pid hash table.  Must be called
+   with SIGCHLD blocked. */
+static void
+pidhash_add (p, job)
+     PROCESS *p;
+     int job;
+{
+  struct pidhash_entry *e, *next, **ntab;
+  int i, nsize;
+
+  if (pidhash_count >= pidhash_size * 2)
+    {
+      nsize = pidhash_size ? pidhash_size * 2 : PIDHASH_INITIAL;
+      ntab = (struct pidhash_entry **)xmalloc (nsize * sizeof (struct pidhash_entry *));
+      for (i = 0; i < nsize; i++)
+	ntab[i] = (struct pidhash_entry *)NULL;
+      for (i = 0; i < pidhash_size; i++)
+	for (e = pidhash[i]; e; e = next)
+	  {
+	    next = e->next;
+	    e->next = ntab[(unsigned long)e->proc->pid & (nsize - 1)];
+	    ntab[(unsigned long)e->proc->pid & (nsize - 1)] = e;
+	  }
+      FREE (pidhash);
+      pidhash = ntab;
+      pidhash_size = nsize;
+    }
+
+  e = (struct pidhash_entry *)xmalloc (sizeof (struct pidhash_entry));
+  e->proc = p;
+  e->job = job;
+  e->next = pidhash[PIDHASH_BUCKET (p->pid)];
+  pidhash[PIDHASH_BUCKET (p->pid)] = e;
+  pidhash_count++;
+}
+
+/* Add the processes in jobs[JOB] to the pid hash table. */
+static void
+pidhash_add_job (job)
+     int job;
+{
+  PROCESS *p;
+
+  p = jobs[job]->pipe;
+  do
+    {
+      pidhash_add (p, job);
+      p = p->next;
+    }
+  while (p != jobs[job]->pipe);
+}
+
+/* Remove the process P from the pid hash table.  P must still have the
+   pid it was added with. */
+static void
+pidhash_remove (p)
+     PROCESS *p;
+{
+  struct pidhash_entry *e, **ep;
+
+  if (pidhash == 0)
+    return;
+
+  for (ep = &pidhash[PIDHASH_BUCKET (p->pid)]; (e = *ep); ep = &e->next)
+    if (e->proc == p)
+      {
+	*ep = e->next;
+	free (e);
+	pidhash_count--;
+	break;
+      }
+}
+
+/* Remove the processes in J from the pid hash table, before J is freed. */
+static void
+pidhash_remove_job (j)
+     JOB *j;
+{
+  PROCESS *p;
+
+  p = j->pipe;
+  do
+    {
+      pidhash_remove (p);
+      p = p->next;
+    }
+  while (p != j->pipe);
+}
+
+/* J is moving to slot JOB in the jobs array; record that in the entries
+   for its processes. */
+static void
+pidhash_set_job (j, job)
+     JOB *j;
+     int job;
+{
+  struct pidhash_entry *e;
+  PROCESS *p;
+
+  if (pidhash == 0)
+    return;
+
+  p = j->pipe;
+  do
+    {
+      for (e = pidhash[PIDHASH_BUCKET (p->pid)]; e; e = e->next)
+	if (e->proc == p)
+	  {
+	    e->job = job;
+	    break;
+	  }
+      p = p->next;
+    }
+  while (p != j->pipe);
+}
+
+/* Return the index of the job that process P belongs to, or NO_JOB. */
+static int
+pidhash_proc_job (p)
+     PROCESS *p;
+{
+  struct pidhash_entry *e;
+
+  if (pidhash == 0)
+    return NO_JOB;
+  for (e = pidhash[PIDHASH_BUCKET (p->pid)]; e; e = e->next)
+    if (e->proc == p)
+      return (e->job);
+  return NO_JOB;
+}
+
+/* Empty the pid hash table without looking at the jobs, which may
+   already be gone. */
+static void
+pidhash_flush ()
+{
+  struct pidhash_entry *e, *next;
+  int i;
+
+  for (i = 0; i < pidhash_size; i++)
+    {
+      for (e = pidhash[i]; e; e = next)
+	{
+	  next = e->next;
+	  free (e);
+	}
+      pidhash[i] = (struct pidhash_entry *)NULL;
+    }
+  pidhash_count = 0;
+}
+
+/* Functions to manage the list of background jobs that have finished but
+   haven't been waited for, in the order they finished.  waitchld adds each
+   job to the list as it reaps the job's last process, so `wait -n' can
+   return the next one without looking through the jobs list.  The jobs
+   are linked through the JOB structs themselves, since waitchld may run in
+   a signal handler. */
+static void
+jdone_add (j)
+     JOB *j;
+{
+  if (j->flags & J_WAITDONE)
+    return;
+  j->flags |= J_WAITDONE;
+  j->done_next = (JOB *)NULL;
+  j->done_prev = jdone_tail;
+  if (jdone_tail)
+    jdone_tail->done_next = j;
+  else
+    jdone_head = j;
+  jdone_tail = j;
+}
+
+static void
+jdone_remove (j)
+     JOB *j;
+{
+  if (j->done_prev)
+    j->done_prev->done_next = j->done_next;
+  else
+    jdone_head = j->done_next;
+  if (j->done_next)
+    j->done_next->done_prev = j->done_prev;
+  else
+    jdone_tail = j->done_prev;
+  j->done_next = j->done_prev = (JOB *)NULL;
+  j->flags &= ~J_WAITDONE;
+}
+
 /* Return the job index that PID belongs to, or NO_JOB if it doesn't
-   belong to any job.  Must be called with SIGCHLD blocked. */
+   belong to any job.  If more than one job has a process with that pid,
+   return the one earliest in the jobs array.  Must be called with
+   SIGCHLD blocked. */
 static int
 find_job (pid, alive_only, procp)
      pid_t pid;
      int alive_only;
      PROCESS **procp;
 {
-  register int i;
+  struct pidhash_entry *e;
   PROCESS *p;
+  int job;
 
-  /* XXX could use js.j_firstj here, and should check js.j_lastj */
-  for (i = 0; i < js.j_jobslots; i++)
-    {
-#if defined (DEBUG)
-      if (i < js.j_firstj && jobs[i])
-	itrace("find_job: job %d non-null before js.j_firstj (%d)", i, js.j_firstj);
-      if (i > js.j_lastj && jobs[i])
-	itrace("find_job: job %d non-null after js.j_lastj (%d)", i, js.j_lastj);
-#endif
-      if (jobs[i])
-	{
-	  p = jobs[i]->pipe;
+  if (pidhash == 0)
+    return (NO_JOB);
 
-	  do
-	    {
-	      if (p->pid == pid && ((alive_only == 0 && PRECYCLED(p) == 0) || PALIVE(p)))
-		{
-		  if (procp)
-		    *procp = p;
-		  return (i);
-		}
-
-	      p = p->next;
-	    }
-	  while (p != jobs[i]->pipe);
-	}
-    }
+  job = NO_JOB;
+  p = (PROCESS *)NULL;
+  for (e = pidhash[PIDHASH_BUCKET (pid)]; e; e = e->next)
+    if (e->proc->pid == pid && (job == NO_JOB || e->job < job) &&
+	((alive_only == 0 && PRECYCLED(e->proc) == 0) || PALIVE(e->proc)))
+      {
+	job = e->job;
+	p = e->proc;
+      }
 
-  return (NO_JOB);
+  if (job != NO_JOB && procp)
+    *procp = p;
+  return (job);
 }
 
 /* Find a job given a PID.  If BLOCK is non-zero, block SIGCHLD as
@@ -2650,6 +2974,76 @@ wait_for_job (job)
   return r;
 }
 
+/* Wait for any background job to finish and return its exit status.  Jobs
+   that finished earlier and haven't been waited for are returned first,
+   in the order they finished.  Returns -1 if there are no jobs left to
+   wait for.  If PIDP is non-null, the pid of the job's last process is
+   stored there.  Jobs started by `jobpool' are considered only with
+   JWAIT_POOL in FLAGS, in which case the job is deleted once its status
+   is returned. */
+int
+wait_for_any_job (flags, pidp)
+     int flags;
+     pid_t *pidp;
+{
+  JOB *j, *next;
+  int job, r;
+  sigset_t set, oset;
+
+  for (;;)
+    {
+      BLOCK_CHILD (set, oset);
+      for (j = jdone_head; j; j = next)
+	{
+	  next = j->done_next;
+	  if (((flags & JWAIT_POOL) != 0) != ((j->flags & J_POOL) != 0))
+	    continue;
+	  jdone_remove (j);
+	  /* Any process will do to find the job's slot */
+	  job = pidhash_proc_job (j->pipe);
+	  if (job == NO_JOB || jobs[job] != j || IS_NOTIFIED (job))
+	    continue;
+
+	  /* As with wait_for_job, the job is removed from the jobs table
+	     the next time dead jobs are cleaned up.  Pool jobs are private
+	     to jobpool, so they go right away. */
+	  r = job_exit_status (job);
+	  last_command_exit_signal = job_exit_signal (job);
+	  if (pidp)
+	    *pidp = find_last_pid (job, 0);
+	  jobs[job]->flags |= J_NOTIFIED;
+	  if (flags & JWAIT_POOL)
+	    delete_job (job, DEL_NOBGPID);
+	  UNBLOCK_CHILD (oset);
+	  return r;
+	}
+
+      /* If no children are left to finish, there is nothing to wait for. */
+      if (js.c_living <= 0)
+	{
+	  UNBLOCK_CHILD (oset);
+	  return -1;
+	}
+
+      /* Block until a child changes state.  waitchld puts the job on the
+	 list if it was the job's last running process. */
+      queue_sigchld = 1;
+      r = waitchld (-1, 1);
+      queue_sigchld = 0;
+      UNBLOCK_CHILD (oset);
+
+      if (r == -1 && errno == ECHILD)
+	{
+	  js.c_living = 0;
+	  mark_all_jobs_as_dead ();
+	  return -1;
+	}
+
+      QUIT;
+      CHECK_TERMSIG;
+    }
+}
+
 /* Print info about dead jobs, and then delete them from the list
    of known jobs.  This does not actually delete jobs when the
    shell is not interactive, because the dead jobs are not marked
@@ -3282,6 +3676,9 @@ set_job_status_and_cleanup (job)
 	setjstatus (job);
 #endif
 
+      if (IS_FOREGROUND (job) == 0)
+	jdone_add (jobs[job]);
+
       /* If this job has a cleanup function associated with it, call it
 	 with `cleanarg' as the single argument, then set the function
 	 pointer to NULL so it is not inadvertently called twice.  The
@@ -3482,7 +3879,8 @@ notify_of_job_status ()
   /* XXX could use js.j_firstj here */
   for (job = 0, dir = (char *)NULL; job < js.j_jobslots; job++)
     {
-      if (jobs[job] && IS_NOTIFIED (job) == 0)
+      /* jobpool collects its own jobs */
+      if (jobs[job] && IS_NOTIFIED (job) == 0 && IS_POOL (job) == 0)
 	{
 	  s = raw_job_exit_status (job);
 	  termsig = WTERMSIG (s);
@@ -3601,6 +3999,12 @@ initialize_job_control (force)
   pid_t t;
   int t_errno;
 
+  if (proccache.data == 0)
+    {
+      ocache_create_growable (proccache, PROCESS, PROCCACHESIZE, PROCCACHEMAX, "process");
+      ocache_create_growable (jobcache, JOB, JOBCACHESIZE, JOBCACHEMAX, "job");
+    }
+
   t_errno = -1;
   shell_pgrp = getpgid (0);
 
@@ -3952,6 +4356,8 @@ delete_all_jobs (running_only)
       if (running_only == 0)
 	{
 	  free ((char *)jobs);
+	  pidhash_flush ();
+	  jdone_head = jdone_tail = (JOB *)NULL;
 	  js.j_jobslots = 0;
 	  js.j_firstj = js.j_lastj = js.j_njobs = 0;
 	}
@@ -4054,7 +4460,7 @@ mark_dead_jobs_as_notified (force)
     /* XXX could use js.j_firstj here */
       for (i = 0; i < js.j_jobslots; i++)
 	{
-	  if (jobs[i] && DEADJOB (i) && (interactive_shell || (find_last_pid (i, 0) != last_asynchronous_pid)))
+	  if (jobs[i] && DEADJOB (i) && IS_POOL (i) == 0 && (interactive_shell || (find_last_pid (i, 0) != last_asynchronous_pid)))
 	    jobs[i]->flags |= J_NOTIFIED;
 	}
       UNBLOCK_CHILD (oset);
@@ -4122,7 +4528,7 @@ itrace("mark_dead_jobs_as_notified: child_max = %d ndead = %d ndeadproc = %d", j
   /* XXX could use js.j_firstj here */
   for (i = 0; i < js.j_jobslots; i++)
     {
-      if (jobs[i] && DEADJOB (i) && (interactive_shell || (find_last_pid (i, 0) != last_asynchronous_pid)))
+      if (jobs[i] && DEADJOB (i) && IS_POOL (i) == 0 && (interactive_shell || (find_last_pid (i, 0) != last_asynchronous_pid)))
 	{
 #if defined (DEBUG)
 	  if (i < js.j_firstj && jobs[i])
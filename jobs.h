@@ -94,11 +94,14 @@ typedef enum { JNONE = -1, JRUNNING = 1, JSTOPPED = 2, JDEAD = 4, JMIXED = 8 } J
 #define J_NOHUP      0x08 /* Don't send SIGHUP to job if shell gets SIGHUP. */
 #define J_STATSAVED  0x10 /* A process in this job had had status saved via $! */
 #define J_ASYNC	     0x20 /* Job was started asynchronously */
+#define J_WAITDONE   0x40 /* On the list of finished jobs for `wait -n' */
+#define J_POOL	     0x80 /* Started by the `jobpool' builtin */
 
 #define IS_FOREGROUND(j)	((jobs[j]->flags & J_FOREGROUND) != 0)
 #define IS_NOTIFIED(j)		((jobs[j]->flags & J_NOTIFIED) != 0)
 #define IS_JOBCONTROL(j)	((jobs[j]->flags & J_JOBCONTROL) != 0)
 #define IS_ASYNC(j)		((jobs[j]->flags & J_ASYNC) != 0)
+#define IS_POOL(j)		((jobs[j]->flags & J_POOL) != 0)
 
 typedef struct job {
   char *wd;	   /* The working directory at time of invocation. */
@@ -111,6 +114,8 @@ typedef struct job {
   sh_vptrfunc_t *j_cleanup; /* Cleanup function to call when job marked JDEAD */
   PTR_T cleanarg;	/* Argument passed to (*j_cleanup)() */
 #endif /* JOB_CONTROL */
+  struct job *done_next;	/* Background jobs that have finished, in */
+  struct job *done_prev;	/* order, if J_WAITDONE is set. */
 } JOB;
 
 struct jobstats {
@@ -137,18 +142,31 @@ struct jobstats {
   JOB *j_lastasync;	/* last async job allocated by stop_pipeline */
 };
 
+typedef int ps_index_t;
+
+/* A saved status.  Slots in use are chained into a hash bucket by index. */
 struct pidstat {
- struct pidstat *next;
- pid_t pid;
- int status;
+  ps_index_t bucket_next;
+  ps_index_t bucket_prev;
+  pid_t pid;
+  int status;
 };
 
+/* The saved statuses of exited background pids live in a circular buffer,
+   oldest first.  Statuses deleted from the middle leave free slots behind
+   until the buffer is compacted.  Once js.c_childmax statuses are saved,
+   saving another drops the oldest. */
 struct bgpids {
-  struct pidstat *list;
-  struct pidstat *end;
+  struct pidstat *storage;
+  ps_index_t head;		/* slot for the next status saved */
+  ps_index_t tail;		/* slot holding the oldest status */
+  ps_index_t nused;		/* slots from tail to head, free or not */
+  ps_index_t nalloc;
   int npid;
 };
 
+#define NO_PIDSTAT (ps_index_t)-1
+
 #define NO_JOB  -1	/* An impossible job array index. */
 #define DUP_JOB -2	/* A possible return value for get_job_spec (). */
 #define BAD_JOBSPEC -3	/* Bad syntax for job spec. */
@@ -156,6 +174,9 @@ struct bgpids {
 /* A value which cannot be a process ID. */
 #define NO_PID (pid_t)-1
 
+/* Flags for wait_for_any_job (). */
+#define JWAIT_POOL	0x01	/* only jobs started by `jobpool'; delete them */
+
 /* System calls. */
 #if !defined (HAVE_UNISTD_H)
 extern pid_t fork (), getpid (), getpgrp ();
@@ -216,6 +237,7 @@ extern int wait_for_single_pid __P((pid_t));
 extern void wait_for_background_pids __P((void));
 extern int wait_for __P((pid_t));
 extern int wait_for_job __P((int));
+extern int wait_for_any_job __P((int, pid_t *));
 
 extern void notify_and_cleanup __P((void));
 extern void reap_dead_jobs __P((void));
@@ -59,6 +59,7 @@ __P ((SCREENFIELD *, char *, int));
 static void screenfield_appendtovalue __P ((SCREENFIELD *, char *));
 
 static int local_output_char __P ((int));
+static void local_output_string __P ((char *));
 
 static void screenform_hint __P ((SCREENFORM *, char *, CF_EDIT_MODE));
 static int cf_insert_or_cycle_screenfield __P ((int, int));
@@ -112,12 +113,20 @@ string_list_contains (list, string)
 }
 
 
-/* Helper function to pass to tputs  */
+/* Helper function to pass to tputs.  Form output goes through readline
+   so that each update is written to the terminal at once. */
 static int
 local_output_char (c)
      int c;
 {
-  return putc (c, stderr);
+  return rl_output_char (c);
+}
+
+static void
+local_output_string (string)
+     char *string;
+{
+  rl_output_chars (string, strlen (string));
 }
 
 
@@ -410,10 +419,12 @@ cf_display_matches (matches, length, max)
       screenfield->completionnextindex = i;
     }
   /* exit displaying buffer */
+  rl_begin_output ();
   screenform_hint (screenform, buff, cf_edit_mode);
   free (buff);
 
   rl_forced_update_display ();
+  rl_end_output ();
 
 }
 
@@ -1275,6 +1286,7 @@ screenform_gotofield (screenform, screenfield, edit_mode)
   int i;
   int delta;
 
+  rl_begin_output ();
   delta = screenform->currenty - screenfield->y;
   if (delta > 0)
     {
@@ -1288,9 +1300,10 @@ screenform_gotofield (screenform, screenfield, edit_mode)
     {
       for (i = 0; i < -delta; i++)
         {
-          putc ('\n', stderr);
+          local_output_char ('\n');
         }
     }
+  rl_end_output ();
   screenform->currentscreenfield = screenfield;
   screenform->currenty = screenfield->y;
 }
@@ -1309,22 +1322,23 @@ screenform_hint (screenform, hint, edit_mode)
   int i;
   int delta;
 
+  rl_begin_output ();
   if (edit_mode == CF_MODE_FORM && UP && *UP)
     {
       delta = (screenform->height - screenform->currenty) - 1;
       /* Go to hint line */
       for (i = 0; i < delta; i++)
         {
-          putc ('\n', stderr);
+          local_output_char ('\n');
         }
 
       /* Output hint on bottom line  - limit to screen width */
       i = strlen (hint) >
         screenform->width ? screenform->width : strlen (hint);
-      fwrite (hint, 1, (unsigned int) i, stderr);
+      rl_output_chars (hint, i);
       /* Clear to end of line */
       for (i = strlen (hint); i < screenform->width; i++)
-        putc (' ', stderr);
+        local_output_char (' ');
 
       /* Go back to field */
       for (i = 0; i < delta; i++)
@@ -1336,12 +1350,13 @@ screenform_hint (screenform, hint, edit_mode)
        * If not UP suppported then just print the help text - do
        * not care if it goes over width of screen
        */
-      fputs (hint, stderr);
-      putc ('\n', stderr);
+      local_output_string (hint);
+      local_output_char ('\n');
     }
   /* Return to first column */
   /* Note that editscreenfield will redraw label */
-  putc ('\r', stderr);
+  local_output_char ('\r');
+  rl_end_output ();
 }
 
 /* Draw the hint text for currently displayed screen field */
@@ -1384,6 +1399,8 @@ screenform_draw (screenform)
   int i;
   int y;
 
+  rl_begin_output ();
+
   /* Display top line */
   buff = xmalloc ((unsigned int) (screenform->width + 1));
   memset (buff, '-', (unsigned int) (screenform->width));
@@ -1398,7 +1415,7 @@ screenform_draw (screenform)
   memcpy (cp, screenform->label, (unsigned int) len);
 
   /* Output string */
-  fputs (buff, stderr);
+  local_output_string (buff);
   rl_crlf ();
 
 
@@ -1415,7 +1432,7 @@ screenform_draw (screenform)
           y++;
         }
       /* Display label */
-      fputs (screenfield->label, stderr);
+      local_output_string (screenfield->label);
 
       /* Display value */
       if (screenfield->displayvalue)
@@ -1424,14 +1441,12 @@ screenform_draw (screenform)
           if ((len + screenform->maxlabelwidth + 4) > screenform->width)
             {
               len = screenform->width - screenform->maxlabelwidth - 5;
-              fwrite (screenfield->displayvalue,
-                      1, (unsigned int) len, stderr);
-              putc ('>', stderr);
+              rl_output_chars (screenfield->displayvalue, len);
+              local_output_char ('>');
             }
           else
             {
-              fwrite (screenfield->displayvalue,
-                      1, (unsigned int) len, stderr);
+              rl_output_chars (screenfield->displayvalue, len);
             }
         }
       /* Go to next line */
@@ -1456,7 +1471,7 @@ screenform_draw (screenform)
           memcpy (cp, string, (unsigned int) len);
 
           /* Output string */
-          fputs (buff, stderr);
+          local_output_string (buff);
           rl_crlf ();
           y++;
         }
@@ -1470,7 +1485,7 @@ screenform_draw (screenform)
 
   memcpy (buff + (screenform->width - len),
           screenform->displaylevel->displaylevel, (unsigned int) len);
-  fputs (buff, stderr);
+  local_output_string (buff);
   rl_crlf ();
   y++;
   rl_crlf ();
@@ -1481,6 +1496,7 @@ screenform_draw (screenform)
   screenform->currenty = screenform->height;
 
   free (buff);
+  rl_end_output ();
 }
 
 /* Layout the fields of the form for the current screen width */
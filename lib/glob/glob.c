@@ -69,6 +69,12 @@
 #  define FREE(x)	if (x) free (x)
 #endif
 
+/* Use openat and fdopendir to walk directory trees for `**' without
+   building a pathname for each directory we open. */
+#if defined (HAVE_OPENAT) && defined (HAVE_FDOPENDIR) && defined (HAVE_FSTATAT) && defined (O_DIRECTORY)
+#  define GLOB_WALKDIRS
+#endif
+
 /* Don't try to alloca() more than this much memory for `struct globval'
    in glob_vector() */
 #ifndef ALLOCA_MAX
@@ -113,7 +119,11 @@ static void wdequote_pathname __P((char *));
 #endif
 static void dequote_pathname __P((char *));
 static int glob_testdir __P((char *));
+static int glob_testdirent __P((struct dirent *, char *, char **, int));
 static char **glob_dir_to_array __P((char *, char **, int));
+#if defined (GLOB_WALKDIRS)
+static char **glob_walkdirs __P((char *, char *, int));
+#endif
 
 /* Compile `glob_loop.c' for single-byte characters. */
 #define CHAR	unsigned char
@@ -340,6 +350,38 @@ glob_testdir (dir)
   return (0);
 }
 
+/* Return 0 if the directory entry DP read from DIR names a directory, -1
+   otherwise.  If the directory entry tells us the file type, we don't need
+   to stat the file; we still have to for symbolic links, which might point
+   to directories.  If SUBDIRP is non-null, the full pathname of the entry,
+   constructed using sh_makepath flags PFLAGS, is returned there; the caller
+   is responsible for freeing it. */
+static int
+glob_testdirent (dp, dir, subdirp, pflags)
+     struct dirent *dp;
+     char *dir;
+     char **subdirp;
+     int pflags;
+{
+  char *subdir;
+  int r;
+
+  if (subdirp == 0 && D_TYPE_KNOWN (dp))
+    return (D_TYPE_ISDIR (dp) ? 0 : -1);
+
+  subdir = sh_makepath (dir, dp->d_name, pflags);
+  if (D_TYPE_KNOWN (dp))
+    r = D_TYPE_ISDIR (dp) ? 0 : -1;
+  else
+    r = glob_testdir (subdir);
+
+  if (subdirp)
+    *subdirp = subdir;
+  else
+    free (subdir);
+  return r;
+}
+
 /* Recursively scan SDIR for directories matching PAT (PAT is always `**').
    FLAGS is simply passed down to the recursive call to glob_vector.  Returns
    a list of matching directory names.  EP, if non-null, is set to the last
@@ -408,6 +450,246 @@ finddirs (pat, sdir, flags, ep, np)
   return ret;
 }
 
+#if defined (GLOB_WALKDIRS)
+/* A directory being read by glob_walkdirs, and the length of the prefix of
+   the pathname buffer that names it. */
+struct walkdir
+{
+  DIR *d;
+  int plen;
+};
+
+/* Return a vector of the names of all the files and directories below DIR,
+   or only the directories if FLAGS includes GX_MATCHDIRS, as recursive
+   calls to glob_vector with the `**' pattern PAT would.  The directories
+   are read iteratively using a stack of open directory streams; each one
+   is opened relative to its parent, and the pathnames are built in a
+   single buffer.  Entries are only stat(2)ed if the directory doesn't tell
+   us their type.  As with glob_vector, the names are not in any
+   particular order.  Returns &glob_error_return if DIR can't be opened,
+   and NULL if we run out of memory or are interrupted. */
+static char **
+glob_walkdirs (pat, dir, flags)
+     char *pat;
+     char *dir;
+     int flags;
+{
+  struct walkdir *stack, *ns;
+  struct dirent *dp;
+  struct stat finfo;
+  DIR *d;
+  char *path, *np, *nextname, **vector, **nv;
+  int sp, ssize, plen, nlen, isdir, fd, lose;
+  unsigned int count, vsize, psize;
+
+#if defined (OPENDIR_NOT_ROBUST)
+  if (glob_testdir (dir) < 0)
+    return ((char **) &glob_error_return);
+#endif
+
+  d = opendir (dir);
+  if (d == NULL)
+    return ((char **) &glob_error_return);
+
+  lose = 0;
+  count = vsize = 0;
+  vector = (char **)NULL;
+  ssize = 16;
+  stack = (struct walkdir *)malloc (ssize * sizeof (struct walkdir));
+  psize = strlen (dir) + 256;
+  path = (char *)malloc (psize);
+  if (stack == 0 || path == 0)
+    {
+      FREE (stack);
+      FREE (path);
+      (void) closedir (d);
+      return ((char **)NULL);
+    }
+
+  /* Start the pathnames the way sh_makepath (dir, name, MP_RMDOT) would,
+     or with nothing if GX_NULLDIR says DIR is a placeholder for `.'. */
+  if (*dir == '\0')
+    {
+      path[0] = '.';
+      path[1] = '/';
+      plen = 2;
+    }
+  else if ((flags & GX_NULLDIR) && dir[0] == '.' && (dir[1] == '\0' || (dir[1] == '/' && dir[2] == '\0')))
+    plen = 0;
+  else
+    {
+      plen = strlen (dir);
+      bcopy (dir, path, plen);
+      if (path[plen - 1] != '/')
+	path[plen++] = '/';
+    }
+
+  sp = 0;
+  stack[sp].d = d;
+  stack[sp++].plen = plen;
+
+  while (sp > 0)
+    {
+      /* Make globbing interruptible in the shell. */
+      if (interrupt_state || terminating_signal)
+	{
+	  lose = 1;
+	  break;
+	}
+
+      d = stack[sp - 1].d;
+      plen = stack[sp - 1].plen;
+
+      dp = readdir (d);
+      if (dp == NULL)
+	{
+	  (void) closedir (d);
+	  sp--;
+	  continue;
+	}
+
+      /* If this directory entry is not to be used, try again.  PAT is
+	 always `**', so this only looks at leading dots. */
+      if (REAL_DIR_ENTRY (dp) == 0 || skipname (pat, dp->d_name, flags))
+	continue;
+
+      nlen = D_NAMLEN (dp);
+      if (plen + nlen + 2 > psize)
+	{
+	  psize = (plen + nlen + 2) * 2;
+	  np = (char *)realloc (path, psize);
+	  if (np == 0)
+	    {
+	      lose = 1;
+	      break;
+	    }
+	  path = np;
+	}
+      bcopy (dp->d_name, path + plen, nlen + 1);
+
+      /* A pathname stat(2) would reject is not a directory, as far as
+	 glob_vector is concerned.  Opening each directory relative to its
+	 parent won't run into those limits, so check them here.  A symbolic
+	 link is followed only if the whole pathname can be resolved, which
+	 counts the links in DIR and in the link targets the way the kernel
+	 does; this is what stops us from following link loops forever. */
+      if (plen + nlen >= PATH_MAX)
+	isdir = -1;
+      else if (D_TYPE_KNOWN (dp))
+	isdir = D_TYPE_ISDIR (dp) ? 0 : -1;
+      else if (fstatat (dirfd (d), dp->d_name, &finfo, AT_SYMLINK_NOFOLLOW) < 0)
+	isdir = -1;
+      else if (S_ISLNK (finfo.st_mode) == 0)
+	isdir = S_ISDIR (finfo.st_mode) ? 0 : -1;
+      else
+	isdir = (stat (path, &finfo) == 0 && S_ISDIR (finfo.st_mode)) ? 0 : -1;
+
+      if (isdir < 0 && (flags & GX_MATCHDIRS))
+	continue;
+
+      if (count + 2 > vsize)
+	{
+	  vsize = vsize ? vsize * 2 : 64;
+	  nv = (char **)realloc (vector, vsize * sizeof (char *));
+	  if (nv == 0)
+	    {
+	      lose = 1;
+	      break;
+	    }
+	  vector = nv;
+	}
+      nextname = (char *)malloc (plen + nlen + 1);
+      if (nextname == 0)
+	{
+	  lose = 1;
+	  break;
+	}
+      bcopy (path, nextname, plen + nlen + 1);
+      vector[count++] = nextname;
+
+      if (isdir < 0)
+	continue;
+
+      /* Directories we can't read are silently skipped, as glob_vector
+	 does. */
+      fd = openat (dirfd (d), dp->d_name, O_RDONLY|O_DIRECTORY);
+      if (fd < 0)
+	continue;
+      if (sp == ssize)
+	{
+	  ssize *= 2;
+	  ns = (struct walkdir *)realloc (stack, ssize * sizeof (struct walkdir));
+	  if (ns == 0)
+	    {
+	      close (fd);
+	      lose = 1;
+	      break;
+	    }
+	  stack = ns;
+	}
+      d = fdopendir (fd);
+      if (d == NULL)
+	{
+	  close (fd);
+	  continue;
+	}
+      path[plen + nlen] = '/';
+      stack[sp].d = d;
+      stack[sp++].plen = plen + nlen + 1;
+    }
+
+  while (sp > 0)
+    (void) closedir (stack[--sp].d);
+  free (stack);
+  free (path);
+
+  /* compat: if GX_ADDCURDIR, add the passed directory also, or an empty
+     placeholder if GX_NULLDIR. */
+  if (lose == 0 && (flags & GX_ADDCURDIR))
+    {
+      if (count + 2 > vsize)
+	{
+	  vsize = count + 2;
+	  nv = (char **)realloc (vector, vsize * sizeof (char *));
+	  if (nv == 0)
+	    lose = 1;
+	  else
+	    vector = nv;
+	}
+      nextname = lose ? (char *)NULL : (char *)malloc (strlen (dir) + 1);
+      if (nextname == 0)
+	lose = 1;
+      else
+	{
+	  if (flags & GX_NULLDIR)
+	    nextname[0] = '\0';
+	  else
+	    strcpy (nextname, dir);
+	  vector[count++] = nextname;
+	}
+    }
+
+  if (lose == 0 && vector == 0)
+    {
+      vector = (char **)malloc (sizeof (char *));
+      lose = vector == 0;
+    }
+
+  if (lose)
+    {
+      while (count > 0)
+	free (vector[--count]);
+      FREE (vector);
+
+      QUIT;
+
+      return ((char **)NULL);
+    }
+
+  vector[count] = NULL;
+  return (vector);
+}
+#endif /* GLOB_WALKDIRS */
      	
 /* Return a vector of names of files in directory DIR
    whose names match glob pattern PAT.
@@ -435,7 +717,8 @@ glob_vector (pat, dir, flags)
   register struct dirent *dp;
   struct globval *lastlink, *e, *dirlist;
   register struct globval *nextlink;
-  register char *nextname, *npat, *subdir;
+  register char *nextname, *npat;
+  char *subdir;
   unsigned int count;
   int lose, skip, ndirs, isdir, sdlen, add_current, patlen;
   register char **name_vector;
@@ -445,6 +728,7 @@ glob_vector (pat, dir, flags)
   int nalloca;
   struct globval *firstmalloc, *tmplink;
   char *convfn;
+  STRMATCH_PATTERN *cpat;
 
   lastlink = 0;
   count = lose = skip = add_current = 0;
@@ -530,6 +814,12 @@ glob_vector (pat, dir, flags)
       skip = 1;
     }
 
+#if defined (GLOB_WALKDIRS)
+  /* `**' matches everything; just walk the directory tree. */
+  if (skip == 0 && (flags & GX_ALLDIRS))
+    return (glob_walkdirs (pat, dir, flags));
+#endif
+
   if (skip == 0)
     {
       /* Open the directory, punting immediately if we cannot.  If opendir
@@ -558,6 +848,9 @@ glob_vector (pat, dir, flags)
 
       add_current = ((flags & (GX_ALLDIRS|GX_ADDCURDIR)) == (GX_ALLDIRS|GX_ADDCURDIR));
 
+      /* Every name in the directory is matched against the same pattern. */
+      cpat = strmatch_compile (pat, mflags);
+
       /* Scan the directory, finding all names that match.
 	 For each name that matches, allocate a struct globval
 	 on the stack and store the name in it.
@@ -593,13 +886,12 @@ glob_vector (pat, dir, flags)
 	    continue;
 
 	  /* If we're only interested in directories, don't bother with files */
-	  if (flags & (GX_MATCHDIRS|GX_ALLDIRS))
+	  if (flags & GX_ALLDIRS)
 	    {
-	      pflags = (flags & GX_ALLDIRS) ? MP_RMDOT : 0;
+	      pflags = MP_RMDOT;
 	      if (flags & GX_NULLDIR)
 		pflags |= MP_IGNDOT;
-	      subdir = sh_makepath (dir, dp->d_name, pflags);
-	      isdir = glob_testdir (subdir);
+	      isdir = glob_testdirent (dp, dir, &subdir, pflags);
 	      if (isdir < 0 && (flags & GX_MATCHDIRS))
 		{
 		  free (subdir);
@@ -649,8 +941,13 @@ glob_vector (pat, dir, flags)
 	    }
 
 	  convfn = fnx_fromfs (dp->d_name, D_NAMLEN (dp));
-	  if (strmatch (pat, convfn, mflags) != FNM_NOMATCH)
+	  if (strmatch_compiled (cpat, convfn) != FNM_NOMATCH)
 	    {
+	      /* Only test whether or not the name is a directory once we
+		 know it matches; this is usually free. */
+	      if ((flags & GX_MATCHDIRS) && glob_testdirent (dp, dir, (char **)NULL, 0) < 0)
+		continue;
+
 	      if (nalloca < ALLOCA_MAX)
 		{
 		  nextlink = (struct globval *) alloca (sizeof (struct globval));
@@ -678,6 +975,7 @@ glob_vector (pat, dir, flags)
 	}
 
       (void) closedir (d);
+      strmatch_dispose (cpat);
     }
 
   /* compat: if GX_ADDCURDIR, add the passed directory also.  Add an empty
@@ -898,7 +1196,11 @@ glob_filename (pathname, flags)
       char **directories;
       register unsigned int i;
 
-      dflags = flags & ~GX_MARKDIRS;
+      /* Only directories can be part of the directory name, so have the
+	 previous levels ignore everything else.  Most systems tell us which
+	 directory entries are directories without requiring a stat, and
+	 this saves trying to open every non-directory as we scan it. */
+      dflags = (flags & ~GX_MARKDIRS) | GX_MATCHDIRS;
       if ((flags & GX_GLOBSTAR) && directory_name[0] == '*' && directory_name[1] == '*' && (directory_name[2] == '/' || directory_name[2] == '\0'))
 	dflags |= GX_ALLDIRS|GX_ADDCURDIR;
 
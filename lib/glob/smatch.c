@@ -402,3 +402,343 @@ xstrmatch (pattern, string, flags)
   return (internal_strmatch ((unsigned char *)pattern, (unsigned char *)string, flags));
 #endif /* !HANDLE_MULTIBYTE */
 }
+
+/* Compiled patterns.  A pattern consisting only of ordinary characters,
+   `?', `*', and bracket expressions is translated once into a sequence of
+   tokens, with each bracket expression evaluated into a bitmap of the
+   characters it matches.  Matching a single-byte string against the
+   tokens then needs no pattern parsing and no recursion.  The literal
+   characters at the start and end of any pattern are used to reject
+   strings without matching at all.  Everything else falls back to
+   internal_strmatch or, for multibyte strings, internal_wstrmatch using a
+   wide-character copy of the pattern made once. */
+
+#define SMP_GENERAL	0	/* use internal_strmatch */
+#define SMP_LITERAL	1	/* only ordinary characters */
+#define SMP_SIMPLE	2	/* ordinary characters, ?, *, and [...] */
+#define SMP_WIDE	3	/* pattern contains multibyte characters */
+
+#define SMT_CHAR	0
+#define SMT_ANY		1
+#define SMT_SET		2
+#define SMT_STAR	3
+
+struct smtoken
+{
+  int type;
+  int val;		/* folded character for SMT_CHAR, index for SMT_SET */
+};
+
+struct strmatch_pattern
+{
+  char *pattern;
+  int flags;
+  int kind;
+  int ntok;
+  struct smtoken *tok;
+  unsigned char (*sets)[32];
+  int prefix;		/* number of leading SMT_CHAR tokens */
+  int suffix;		/* number of trailing SMT_CHAR tokens, -1 if unknown */
+  int minlen;		/* shortest string the tokens can match */
+#if HANDLE_MULTIBYTE
+  wchar_t *wpattern;
+  int wfailed;
+#endif
+};
+
+#define FOLD(c) ((flags & FNM_CASEFOLD) \
+	? TOLOWER ((unsigned char)c) \
+	: ((unsigned char)c))
+
+#if !defined (FREE)
+#  define FREE(x)	if (x) free (x)
+#endif
+
+#define SETBIT(m, c)	((m)[(unsigned char)(c) >> 3] |= (1 << ((unsigned char)(c) & 7)))
+#define TSTBIT(m, c)	((m)[(unsigned char)(c) >> 3] & (1 << ((unsigned char)(c) & 7)))
+
+static int
+smp_tokenize (cp)
+     STRMATCH_PATTERN *cp;
+{
+  unsigned char *p, *end, *e;
+  int flags, c, t, nsets, i;
+
+  flags = cp->flags;
+  nsets = 0;
+
+  for (t = 0, p = (unsigned char *)cp->pattern; c = *p++; t++)
+    {
+      if ((flags & FNM_EXTMATCH) && *p == '(' &&
+	  (c == '+' || c == '*' || c == '?' || c == '@' || c == '!'))	/* ) */
+	break;
+      switch (c)
+	{
+	case '\\':
+	  if ((flags & FNM_NOESCAPE) == 0)
+	    {
+	      if (*p == '\0')
+		return 0;
+	      c = *p++;
+	    }
+	  cp->tok[t].type = SMT_CHAR;
+	  cp->tok[t].val = FOLD (c);
+	  break;
+	case '?':
+	  cp->tok[t].type = SMT_ANY;
+	  break;
+	case '*':
+	  cp->tok[t].type = SMT_STAR;
+	  break;
+	case '[':
+	  /* Leave collating symbols and equivalence classes, whose extent
+	     depends on the character being tested, to the interpreter. */
+	  for (e = p; *e; e++)
+	    if (e[0] == '[' && (e[1] == '.' || e[1] == '='))
+	      return 0;
+	  memset (cp->sets[nsets], 0, sizeof (cp->sets[0]));
+	  /* Let brackmatch decide which characters the expression matches,
+	     so collating, ranges, and character classes behave exactly as
+	     they do when the pattern is interpreted. */
+	  for (end = 0, i = 1; i < 256; i++)
+	    {
+	      e = brackmatch (p, i, flags);
+	      if (e == 0)
+		continue;
+	      if (end && e != end)
+		return 0;
+	      end = e;
+	      SETBIT (cp->sets[nsets], i);
+	    }
+	  if (end == 0)
+	    return 0;
+	  p = end;
+	  cp->tok[t].type = SMT_SET;
+	  cp->tok[t].val = nsets++;
+	  break;
+	default:
+	  cp->tok[t].type = SMT_CHAR;
+	  cp->tok[t].val = FOLD (c);
+	  break;
+	}
+    }
+
+  cp->ntok = t;
+  for (i = 0; i < t && cp->tok[i].type == SMT_CHAR; i++)
+    ;
+  cp->prefix = i;
+
+  /* Stop here if we found an extended glob pattern. */
+  if (c)
+    return 0;
+
+  for (i = 0; i < t && cp->tok[t - i - 1].type == SMT_CHAR; i++)
+    ;
+  cp->suffix = i;
+
+  for (cp->minlen = i = 0; i < t; i++)
+    if (cp->tok[i].type != SMT_STAR)
+      cp->minlen++;
+
+  return (cp->prefix == t ? SMP_LITERAL : SMP_SIMPLE);
+}
+
+STRMATCH_PATTERN *
+strmatch_compile (pattern, flags)
+     char *pattern;
+     int flags;
+{
+  STRMATCH_PATTERN *cp;
+  size_t plen, nsets;
+  char *p;
+
+  /* Allocate the structure, the tokens, and the bitmaps in one piece;
+     callers often compile patterns they match against only a few
+     strings. */
+  plen = strlen (pattern);
+  for (nsets = 0, p = pattern; p = strchr (p, '['); p++)
+    nsets++;
+  cp = (STRMATCH_PATTERN *)xmalloc (sizeof (STRMATCH_PATTERN) +
+				    nsets * sizeof (cp->sets[0]) +
+				    (plen + 1) * sizeof (struct smtoken));
+  cp->sets = (unsigned char (*)[32])(cp + 1);
+  cp->tok = (struct smtoken *)(cp->sets + nsets);
+  cp->pattern = pattern;
+  cp->flags = flags;
+  cp->ntok = cp->prefix = cp->minlen = 0;
+  cp->suffix = -1;
+#if HANDLE_MULTIBYTE
+  cp->wpattern = 0;
+  cp->wfailed = 0;
+
+  if (MB_CUR_MAX > 1 && mbsmbchar (pattern))
+    {
+      cp->kind = SMP_WIDE;
+      return cp;
+    }
+#endif
+
+  cp->kind = smp_tokenize (cp);
+  /* Leading directories make the end of the string unpredictable */
+  if (flags & FNM_LEADING_DIR)
+    {
+      cp->kind = SMP_GENERAL;
+      cp->suffix = -1;
+    }
+  else if (cp->kind == SMP_GENERAL)
+    cp->suffix = -1;
+  return cp;
+}
+
+void
+strmatch_dispose (cp)
+     STRMATCH_PATTERN *cp;
+{
+#if HANDLE_MULTIBYTE
+  FREE (cp->wpattern);
+#endif
+  free (cp);
+}
+
+/* Match the single-byte STRING, of length LEN, against the tokens in CP.
+   This is the usual iterative wildcard matcher: when a token fails to
+   match, let the most recent `*' absorb one more character and try again.
+   Callers handle FNM_LEADING_DIR and `/' under FNM_PATHNAME. */
+static int
+smp_match (cp, string, len)
+     STRMATCH_PATTERN *cp;
+     unsigned char *string;
+     int len;
+{
+  register int si, ti;
+  int star_ti, star_si, flags, sc;
+  struct smtoken *tp;
+
+  flags = cp->flags;
+  si = ti = 0;
+  star_ti = star_si = -1;
+
+  for (;;)
+    {
+      if (ti < cp->ntok)
+	{
+	  tp = cp->tok + ti;
+	  if (tp->type == SMT_STAR)
+	    {
+	      /* A trailing `*' matches anything, even a leading `.'. */
+	      if (ti == cp->ntok - 1)
+		return 0;
+	      if ((flags & FNM_PERIOD) && si == 0 && string[0] == '.')
+		return FNM_NOMATCH;
+	      star_ti = ti++;
+	      star_si = si;
+	      continue;
+	    }
+	  if (si < len)
+	    {
+	      sc = string[si];
+	      switch (tp->type)
+		{
+		case SMT_CHAR:
+		  if (FOLD (sc) == tp->val)
+		    {
+		      si++; ti++;
+		      continue;
+		    }
+		  break;
+		case SMT_ANY:
+		case SMT_SET:
+		  if ((flags & FNM_PERIOD) && si == 0 && sc == '.')
+		    return FNM_NOMATCH;
+		  if (tp->type == SMT_ANY || TSTBIT (cp->sets[tp->val], sc))
+		    {
+		      si++; ti++;
+		      continue;
+		    }
+		  break;
+		}
+	    }
+	}
+      else if (si == len)
+	return 0;
+
+      if (star_ti < 0 || star_si >= len)
+	return FNM_NOMATCH;
+      si = ++star_si;
+      ti = star_ti + 1;
+    }
+}
+
+#if HANDLE_MULTIBYTE
+static int
+smp_wmatch (cp, string)
+     STRMATCH_PATTERN *cp;
+     char *string;
+{
+  wchar_t *wstring;
+  size_t n;
+  int ret;
+
+  if (cp->wpattern == 0 && cp->wfailed == 0)
+    {
+      n = xdupmbstowcs (&cp->wpattern, NULL, cp->pattern);
+      if (n == (size_t)-1 || n == (size_t)-2)
+	{
+	  cp->wpattern = 0;
+	  cp->wfailed = 1;
+	}
+    }
+  if (cp->wfailed)
+    return (internal_strmatch ((unsigned char *)cp->pattern, (unsigned char *)string, cp->flags));
+
+  n = xdupmbstowcs (&wstring, NULL, string);
+  if (n == (size_t)-1 || n == (size_t)-2)
+    return (internal_strmatch ((unsigned char *)cp->pattern, (unsigned char *)string, cp->flags));
+
+  ret = internal_wstrmatch (cp->wpattern, wstring, cp->flags);
+  free (wstring);
+  return ret;
+}
+#endif
+
+/* Match STRING against the compiled pattern CP, returning zero if it
+   matches, FNM_NOMATCH if not.  The result is the same as calling
+   strmatch with the pattern and flags passed to strmatch_compile. */
+int
+strmatch_compiled (cp, string)
+     STRMATCH_PATTERN *cp;
+     char *string;
+{
+  register int i, len;
+  int flags;
+  unsigned char *s;
+
+  if (string == 0 || cp == 0)
+    return FNM_NOMATCH;
+
+  flags = cp->flags;
+#if HANDLE_MULTIBYTE
+  if (cp->kind == SMP_WIDE ||
+	(MB_CUR_MAX > 1 && (flags & FNM_SBSTRING) == 0 && mbsmbchar (string)))
+    return (smp_wmatch (cp, string));
+#endif
+
+  s = (unsigned char *)string;
+  len = strlen (string);
+  if (len < cp->minlen)
+    return FNM_NOMATCH;
+  for (i = 0; i < cp->prefix; i++)
+    if (FOLD (s[i]) != cp->tok[i].val)
+      return FNM_NOMATCH;
+  for (i = 1; i <= cp->suffix; i++)
+    if (FOLD (s[len - i]) != cp->tok[cp->ntok - i].val)
+      return FNM_NOMATCH;
+
+  if (cp->kind == SMP_LITERAL)
+    return (len == cp->ntok ? 0 : FNM_NOMATCH);
+  else if (cp->kind == SMP_SIMPLE &&
+	   ((flags & FNM_PATHNAME) == 0 || memchr (s, '/', len) == 0))
+    return (smp_match (cp, s, len));
+
+  return (internal_strmatch ((unsigned char *)cp->pattern, s, flags));
+}
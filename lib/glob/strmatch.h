@@ -46,6 +46,10 @@
 #define FNM_CASEFOLD	(1 << 4) /* Compare without regard to case. */
 #define FNM_EXTMATCH	(1 << 5) /* Use ksh-like extended matching. */
 
+/* Only valid for strmatch_compile: the strings matched against the pattern
+   are known to contain no multibyte characters. */
+#define FNM_SBSTRING	(1 << 6)
+
 /* Value returned by `strmatch' if STRING does not match PATTERN.  */
 #undef FNM_NOMATCH
 
@@ -59,4 +63,12 @@ extern int strmatch __P((char *, char *, int));
 extern int wcsmatch __P((wchar_t *, wchar_t *, int));
 #endif
 
+/* A pattern analyzed once by strmatch_compile so it can be matched against
+   many strings. */
+typedef struct strmatch_pattern STRMATCH_PATTERN;
+
+extern STRMATCH_PATTERN *strmatch_compile __P((char *, int));
+extern int strmatch_compiled __P((STRMATCH_PATTERN *, char *));
+extern void strmatch_dispose __P((STRMATCH_PATTERN *));
+
 #endif /* _STRMATCH_H */
@@ -89,6 +89,16 @@
 #  include "getpagesize.h"
 #endif
 
+#if defined (HAVE_MMAP) && defined (HAVE_MUNMAP)
+#  include <sys/mman.h>
+#  if !defined (MAP_ANONYMOUS) && defined (MAP_ANON)
+#    define MAP_ANONYMOUS MAP_ANON
+#  endif
+#  if defined (MAP_ANONYMOUS)
+#    define USE_MMAP
+#  endif
+#endif
+
 #include "imalloc.h"
 #ifdef MALLOC_STATS
 #  include "mstats.h"
@@ -186,9 +196,37 @@ typedef union _malloc_guard {
 #define COMBINE_MIN	2
 #define COMBINE_MAX	(pagebucket - 1)	/* XXX */
 
+/* Look at no more than this many blocks on a free list when searching
+   for two adjacent ones to coalesce. */
+#define COMBINE_SCAN	32
+
 #define LESSCORE_MIN	10
 #define LESSCORE_FRC	13
 
+#if defined (USE_MMAP)
+/* Requests needing more than mmap_threshold bytes get a mapping of their
+   own, rounded up to a multiple of the page size rather than to the next
+   power of two, which goes back to the system as soon as it's freed.  Its
+   mh_index is MMAP_BUCKET.  The threshold starts at MMAP_THRESHOLD_MIN;
+   freeing a mapped block raises it to the size of that block's bucket, up to
+   MMAP_THRESHOLD_MAX, so blocks of a size the shell keeps allocating and
+   freeing come from the free lists instead of costing a fresh mapping
+   each time. */
+#  define MMAP_THRESHOLD_MIN	(1UL << 17)	/* 128K, binsize(14) */
+#  define MMAP_THRESHOLD_MAX	(1UL << 25)	/* 32M, binsize(22) */
+#  define MMAP_BUCKET		NBUCKETS
+#  define MMAP_SIZE(nb)		(((nb) + pagesz - 1) & ~(pagesz - 1))
+#  define MMAPPED(nu)		((nu) == MMAP_BUCKET)
+
+/* malloc_release_idle gives back the pages of free blocks at least this
+   big (64K), past their header, until they're reused.  A released block
+   has mh_magic2 set to RELEASED, so it isn't released twice. */
+#  define MADVISE_MIN		13
+#  define RELEASED		0x5252
+#else
+#  define MMAPPED(nu)		0
+#endif
+
 #define STARTBUCK	1
 
 /* Flags for the internal functions. */
@@ -229,6 +267,10 @@ static int maxbuck;	/* highest bucket receiving allocation request. */
 
 static char *memtop;	/* top of heap */
 
+#if defined (USE_MMAP)
+static unsigned long mmap_threshold = MMAP_THRESHOLD_MIN;
+#endif
+
 static const unsigned long binsizes[NBUCKETS] = {
 	8UL, 16UL, 32UL, 64UL, 128UL, 256UL, 512UL, 1024UL, 2048UL, 4096UL,
 	8192UL, 16384UL, 32768UL, 65536UL, 131072UL, 262144UL, 524288UL,
@@ -278,6 +320,10 @@ int malloc_flags = 0;	/* future use */
 int malloc_trace = 0;	/* trace allocations and frees to stderr */
 int malloc_register = 0;	/* future use */
 
+/* If non-null, called with the size of each block the application asks
+   for, so it can keep a profile of its allocations. */
+static void (*malloc_profiler) __P((size_t)) = 0;
+
 #ifdef MALLOC_TRACE
 char _malloc_trace_buckets[NBUCKETS];
 
@@ -320,15 +366,17 @@ xbotch (mem, e, s, file, line)
 }
 
 /* Coalesce two adjacent free blocks off the free list for size NU - 1,
-   as long as we can find two adjacent free blocks.  nextf[NU -1] is
-   assumed to not be busy; the caller (morecore()) checks for this. 
-   BUSY[NU] must be set to 1. */
+   as long as we can find two adjacent free blocks among the first
+   COMBINE_SCAN blocks on the list.  The blocks need not be next to each
+   other on the list.  nextf[NU -1] is assumed to not be busy; the caller
+   (morecore()) checks for this.  BUSY[NU] must be set to 1. */
 static void
 bcoalesce (nu)
      register int nu;
 {
-  register union mhead *mp, *mp1, *mp2;
-  register int nbuck;
+  register union mhead *mp1, *mp2;
+  union mhead *prev1, *prev2;
+  register int nbuck, n1, n2;
   unsigned long siz;
 
   nbuck = nu - 1;
@@ -338,42 +386,41 @@ bcoalesce (nu)
   busy[nbuck] = 1;
   siz = binsize (nbuck);
 
-  mp2 = mp1 = nextf[nbuck];
-  mp = CHAIN (mp1);
-  while (mp && mp != (union mhead *)((char *)mp1 + siz))
+  /* Find a block MP1 whose successor in memory, MP2, is also free. */
+  mp2 = 0;
+  for (n1 = 0, prev1 = 0, mp1 = nextf[nbuck]; mp1 && n1 < COMBINE_SCAN; n1++)
     {
-      mp2 = mp1;
-      mp1 = mp;
-      mp = CHAIN (mp);
+      for (n2 = 0, prev2 = 0, mp2 = nextf[nbuck]; mp2 && n2 < COMBINE_SCAN; n2++)
+	{
+	  if (mp2 == (union mhead *)((char *)mp1 + siz))
+	    break;
+	  prev2 = mp2;
+	  mp2 = CHAIN (mp2);
+	}
+      if (mp2 && n2 < COMBINE_SCAN)
+	break;
+      mp2 = 0;
+      prev1 = mp1;
+      mp1 = CHAIN (mp1);
     }
 
-  if (mp == 0)
+  if (mp2 == 0)
     {
       busy[nbuck] = 0;
       return;
     }
 
-  /* OK, now we have mp1 pointing to the block we want to add to nextf[NU].
-     CHAIN(mp2) must equal mp1.  Check that mp1 and mp are adjacent. */
-  if (mp2 != mp1 && CHAIN(mp2) != mp1)
-    {
-      busy[nbuck] = 0;
-      xbotch ((PTR_T)0, 0, "bcoalesce: CHAIN(mp2) != mp1", (char *)NULL, 0);
-    }
-
-#ifdef MALLOC_DEBUG
-  if (CHAIN (mp1) != (union mhead *)((char *)mp1 + siz))
-    {
-      busy[nbuck] = 0;
-      return;	/* not adjacent */
-    }
-#endif
-
-  /* Since they are adjacent, remove them from the free list */
-  if (mp1 == nextf[nbuck])
-    nextf[nbuck] = CHAIN (mp);
+  /* Remove them both from the free list. */
+  if (prev1)
+    CHAIN (prev1) = CHAIN (mp1);
+  else
+    nextf[nbuck] = CHAIN (mp1);
+  if (prev2 == mp1)
+    prev2 = prev1;
+  if (prev2)
+    CHAIN (prev2) = CHAIN (mp2);
   else
-    CHAIN (mp2) = CHAIN (mp);
+    nextf[nbuck] = CHAIN (mp2);
   busy[nbuck] = 0;
 
 #ifdef MALLOC_STATS
@@ -547,6 +594,137 @@ lesscore (nu)			/* give system back some memory */
 #endif
 }
 
+#if defined (USE_MMAP)
+/* Get a mapping big enough for a block of NBYTES bytes. */
+static union mhead *
+mmap_block (nbytes)
+     long nbytes;
+{
+  union mhead *mp;
+  long siz;
+
+  siz = MMAP_SIZE (nbytes);
+  mp = (union mhead *)mmap ((PTR_T)0, siz, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if ((PTR_T)mp == MAP_FAILED)
+    return ((union mhead *)NULL);
+
+#ifdef MALLOC_STATS
+  _mstats.nmmap++;
+  _mstats.tmmap += siz;
+#endif
+  return mp;
+}
+
+/* Give the mapping holding block MP, which holds NBYTES bytes including
+   the malloc overhead, back to the system. */
+static void
+munmap_block (mp, nbytes)
+     union mhead *mp;
+     long nbytes;
+{
+  long siz;
+
+  siz = MMAP_SIZE (nbytes);
+  munmap ((PTR_T)mp, siz);
+
+#ifdef MALLOC_STATS
+  _mstats.nmunmap++;
+  _mstats.tmmap -= siz;
+#endif
+}
+
+/* Resize the mapping holding block MP, which currently holds OBYTES bytes
+   including the malloc overhead, to hold NBYTES.  The block may move.
+   Returns the block, or NULL, leaving MP alone, if the mapping can't be
+   resized. */
+static union mhead *
+mremap_block (mp, obytes, nbytes)
+     union mhead *mp;
+     long obytes, nbytes;
+{
+  union mhead *np;
+  long osiz, nsiz;
+
+  osiz = MMAP_SIZE (obytes);
+  nsiz = MMAP_SIZE (nbytes);
+  if (osiz == nsiz)
+    return mp;
+
+#if defined (MREMAP_MAYMOVE)
+  np = (union mhead *)mremap ((PTR_T)mp, osiz, nsiz, MREMAP_MAYMOVE);
+  if ((PTR_T)np == MAP_FAILED)
+    return ((union mhead *)NULL);
+#  ifdef MALLOC_STATS
+  _mstats.nmremap++;
+  _mstats.tmmap += nsiz - osiz;
+#  endif
+#else
+  if ((np = mmap_block (nbytes)) == 0)
+    return ((union mhead *)NULL);
+  FASTCOPY (mp, np, (obytes < nbytes) ? obytes : nbytes);
+  munmap_block (mp, obytes);
+#endif
+
+  return np;
+}
+
+#  if defined (MADV_DONTNEED)
+/* Tell the system it can reclaim the pages of free block MP, which is on
+   the free list for bucket NU, past the page holding its header and the
+   free list pointer.  They read back as zeros when the block is reused. */
+static void
+madvise_block (mp, nu)
+     union mhead *mp;
+     int nu;
+{
+  char *start, *end;
+
+  mp->mh_magic2 = RELEASED;
+
+  start = (char *)(((long)mp + MOVERHEAD + sizeof (char *) + pagesz - 1) & ~(pagesz - 1));
+  end = (char *)(((long)mp + binsize (nu)) & ~(pagesz - 1));
+  if (end <= start)
+    return;
+
+  madvise ((PTR_T)start, end - start, MADV_DONTNEED);
+
+#ifdef MALLOC_STATS
+  _mstats.nmadvise++;
+  _mstats.tmadvise += end - start;
+#endif
+}
+#  endif /* MADV_DONTNEED */
+#endif /* USE_MMAP */
+
+/* Give the pages of large blocks sitting on the free lists back to the
+   system.  An application calls this when it's idle, so a shell that
+   once needed a lot of memory doesn't keep it resident forever; doing it
+   on every free would make programs that repeatedly allocate and free a
+   large block fault its pages in again each time. */
+void
+malloc_release_idle ()
+{
+#if defined (USE_MMAP) && defined (MADV_DONTNEED)
+  register union mhead *mp;
+  register int nu;
+  sigset_t set, oset;
+
+  if (pagesz == 0)
+    return;
+
+  block_signals (&set, &oset);
+  for (nu = MADVISE_MIN; nu <= maxbuck; nu++)
+    {
+      if (busy[nu])
+	continue;
+      for (mp = nextf[nu]; mp; mp = CHAIN (mp))
+	if (mp->mh_magic2 != RELEASED)
+	  madvise_block (mp, nu);
+    }
+  unblock_signals (&set, &oset);
+#endif
+}
+
 /* Ask system for more memory; add to NEXTF[NU].  BUSY[NU] must be set to 1. */  
 static void
 morecore (nu)
@@ -743,6 +921,9 @@ internal_malloc (n, file, line, flags)		/* get a block */
   long nbytes;
   mguard_t mg;
 
+  if (malloc_profiler && (flags & MALLOC_NOTRACE) == 0)
+    (*malloc_profiler) (n);
+
   /* Get the system page size and align break pointer so future sbrks will
      be page-aligned.  The page size must be at least 1K -- anything
      smaller is increased. */
@@ -764,6 +945,16 @@ internal_malloc (n, file, line, flags)		/* get a block */
   if (nunits >= NBUCKETS)
     return ((PTR_T) NULL);
 
+#if defined (USE_MMAP)
+  if (nbytes > mmap_threshold)
+    {
+      if ((p = mmap_block (nbytes)) == NULL)
+	return ((PTR_T) NULL);
+      nunits = MMAP_BUCKET;
+      goto alloc_block;
+    }
+#endif
+
   /* In case this is reentrant use of malloc from signal handler,
      pick a block size that no other malloc level is currently
      trying to allocate.  That's the easiest harmless way not to
@@ -796,6 +987,11 @@ internal_malloc (n, file, line, flags)		/* get a block */
   if (p->mh_alloc != ISFREE || p->mh_index != nunits)
     xbotch ((PTR_T)(p+1), 0, _("malloc: block on free list clobbered"), file, line);
 
+#if defined (USE_MMAP)
+alloc_block:
+  p->mh_index = nunits;
+#endif
+
   /* Fill in the info, and set up the magic numbers for range checking. */
   p->mh_alloc = ISALLOC;
   p->mh_magic2 = MAGIC2;
@@ -812,8 +1008,11 @@ internal_malloc (n, file, line, flags)		/* get a block */
     MALLOC_MEMSET ((char *)(p + 1), 0xdf, n);	/* scramble previous contents */
 #endif
 #ifdef MALLOC_STATS
-  _mstats.nmalloc[nunits]++;
-  _mstats.tmalloc[nunits]++;
+  if (MMAPPED (nunits) == 0)
+    {
+      _mstats.nmalloc[nunits]++;
+      _mstats.tmalloc[nunits]++;
+    }
   _mstats.nmal++;
   _mstats.bytesreq += n;
 #endif /* MALLOC_STATS */
@@ -821,7 +1020,7 @@ internal_malloc (n, file, line, flags)		/* get a block */
 #ifdef MALLOC_TRACE
   if (malloc_trace && (flags & MALLOC_NOTRACE) == 0)
     mtrace_alloc ("malloc", p + 1, n, file, line);
-  else if (_malloc_trace_buckets[nunits])
+  else if (MMAPPED (nunits) == 0 && _malloc_trace_buckets[nunits])
     mtrace_alloc ("malloc", p + 1, n, file, line);
 #endif
 
@@ -891,7 +1090,7 @@ internal_free (mem, file, line, flags)
      fail then.  Using MALLOC_REGISTER will help here, since it saves the
      original number of bytes requested. */
 
-  if (IN_BUCKET(nbytes, nunits) == 0)
+  if (MMAPPED (nunits) ? (nbytes <= MMAP_THRESHOLD_MIN) : (IN_BUCKET(nbytes, nunits) == 0))
     xbotch (mem, ERR_UNDERFLOW,
 	    _("free: underflow detected; mh_nbytes out of range"), file, line);
 
@@ -901,6 +1100,23 @@ internal_free (mem, file, line, flags)
   if (mg.i != p->mh_nbytes)
     xbotch (mem, ERR_ASSERT_FAILED, _("free: start and end chunk sizes differ"), file, line);
 
+#if defined (USE_MMAP)
+  if (MMAPPED (nunits))
+    {
+      munmap_block (p, nbytes);
+      /* Raise the threshold to the whole bucket, so a block that keeps
+	 growing a little at a time (a string being appended to) stays
+	 on the free lists. */
+      if (nbytes > mmap_threshold && nbytes <= MMAP_THRESHOLD_MAX)
+	{
+	  for (nunits = 14; binsize (nunits) < nbytes; nunits++)
+	    ;
+	  mmap_threshold = binsize (nunits);
+	}
+      goto free_return;
+    }
+#endif
+
 #if 1
   if (nunits >= LESSCORE_MIN && ((char *)p + binsize(nunits) == memtop))
 #else
@@ -933,6 +1149,9 @@ internal_free (mem, file, line, flags)
     }
 
   p->mh_alloc = ISFREE;
+#if defined (USE_MMAP)
+  p->mh_magic2 = 0;		/* not yet released */
+#endif
   /* Protect against signal handlers calling malloc.  */
   busy[nunits] = 1;
   /* Put this block on the free list.  */
@@ -944,14 +1163,15 @@ free_return:
   ;		/* Empty statement in case this is the end of the function */
 
 #ifdef MALLOC_STATS
-  _mstats.nmalloc[nunits]--;
+  if (MMAPPED (nunits) == 0)
+    _mstats.nmalloc[nunits]--;
   _mstats.nfre++;
 #endif /* MALLOC_STATS */
 
 #ifdef MALLOC_TRACE
   if (malloc_trace && (flags & MALLOC_NOTRACE) == 0)
     mtrace_free (mem, ubytes, file, line);
-  else if (_malloc_trace_buckets[nunits])
+  else if (MMAPPED (nunits) == 0 && _malloc_trace_buckets[nunits])
     mtrace_free (mem, ubytes, file, line);
 #endif
 
@@ -992,9 +1212,12 @@ internal_realloc (mem, n, file, line, flags)
   if ((p = (union mhead *) mem) == 0)
     return internal_malloc (n, file, line, MALLOC_INTERNAL);
 
+  if (malloc_profiler)
+    (*malloc_profiler) (n);
+
   p--;
   nunits = p->mh_index;
-  ASSERT (nunits < NBUCKETS);
+  ASSERT (nunits < NBUCKETS || MMAPPED (nunits));
 
   if (p->mh_alloc != ISALLOC)
     xbotch (mem, ERR_UNALLOC,
@@ -1011,7 +1234,7 @@ internal_realloc (mem, n, file, line, flags)
      checks against the size recorded at the end of the chunk will probably
      fail then.  Using MALLOC_REGISTER will help here, since it saves the
      original number of bytes requested. */
-  if (IN_BUCKET(nbytes, nunits) == 0)
+  if (MMAPPED (nunits) ? (nbytes <= MMAP_THRESHOLD_MIN) : (IN_BUCKET(nbytes, nunits) == 0))
     xbotch (mem, ERR_UNDERFLOW,
 	    _("realloc: underflow detected; mh_nbytes out of range"), file, line);
 
@@ -1032,8 +1255,26 @@ internal_realloc (mem, n, file, line, flags)
   /* See if desired size rounds to same power of 2 as actual size. */
   nbytes = ALLOCATED_BYTES(n);
 
+#if defined (USE_MMAP)
+  /* A mapped block that is still big enough to need a mapping of its own
+     is resized in place, or moved by the system without our copying. */
+  if (MMAPPED (nunits) && nbytes > MMAP_THRESHOLD_MIN)
+    {
+      if ((p = mremap_block (p, ALLOCATED_BYTES (tocopy), nbytes)) == 0)
+	return 0;
+      mem = (PTR_T) (p + 1);
+      m = (char *)mem + (p->mh_nbytes = n);
+
+      mg.i = n;
+      z = mg.s;
+      *m++ = *z++, *m++ = *z++, *m++ = *z++, *m++ = *z++;
+
+      return mem;
+    }
+#endif
+
   /* If ok, use the same block, just marking its size as changed.  */
-  if (RIGHT_BUCKET(nbytes, nunits))
+  if (MMAPPED (nunits) == 0 && RIGHT_BUCKET(nbytes, nunits))
     {
 #if 0
       m = (char *)mem + p->mh_nbytes;
@@ -1066,7 +1307,7 @@ internal_realloc (mem, n, file, line, flags)
 #ifdef MALLOC_TRACE
   if (malloc_trace && (flags & MALLOC_NOTRACE) == 0)
     mtrace_alloc ("realloc", m, n, file, line);
-  else if (_malloc_trace_buckets[nunits])
+  else if (MMAPPED (nunits) == 0 && _malloc_trace_buckets[nunits])
     mtrace_alloc ("realloc", m, n, file, line);
 #endif
 
@@ -1157,6 +1398,16 @@ internal_cfree (p, file, line, flags)
 }
 #endif /* !NO_CALLOC */
 
+/* Arrange for FN to be called with the size of each allocation, or stop
+   calling it if FN is NULL.  FN may allocate memory itself; it must
+   guard against being called recursively. */
+void
+malloc_set_profiler (fn)
+     void (*fn) __P((size_t));
+{
+  malloc_profiler = fn;
+}
+
 #ifdef MALLOC_STATS
 int
 malloc_free_blocks (size)
@@ -57,6 +57,15 @@
  *
  * TBCOALESCE is the number of times two adjacent smaller blocks off the free
  * list were combined to satisfy a larger request.
+ *
+ * NMMAP and NMUNMAP are the number of large blocks given mappings of their
+ * own and the number of those mappings returned to the system; NMREMAP is
+ * the number of times a mapping was resized by realloc().  TMMAP is the
+ * number of bytes currently mapped.
+ *
+ * NMADVISE is the number of times the pages of a large free block were
+ * handed back to the system with madvise(); TMADVISE is the total number
+ * of bytes handed back that way.
  */
 struct _malstats {
   int nmalloc[NBUCKETS];
@@ -77,6 +86,12 @@ struct _malstats {
   int nsplit[NBUCKETS];
   int tbcoalesce;
   int ncoalesce[NBUCKETS];
+  int nmmap;
+  int nmunmap;
+  int nmremap;
+  unsigned long tmmap;
+  int nmadvise;
+  unsigned long tmadvise;
 };
 
 /* Return statistics describing allocation of blocks of size BLOCKSIZE.
@@ -62,6 +62,10 @@ extern void mregister_dump_table __P((void));
 extern void mregister_table_init __P((void));
 extern int malloc_set_register __P((int));
 
+/* malloc.c */
+extern void malloc_release_idle __P((void));
+extern void malloc_set_profiler __P((void (*)(size_t)));
+
 /* stats.c */
 extern void print_malloc_stats __P((char *));
 extern void fprint_malloc_stats ();	/* full prototype requires stdio.h */
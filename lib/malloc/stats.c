@@ -87,6 +87,7 @@ malloc_stats ()
       result.bytesfree += v.nfree * v.blocksize;
       result.bytesused += v.nused * v.blocksize;
     }
+  result.bytesused += _mstats.tmmap;
   return (result);
 }
 
@@ -108,6 +109,7 @@ _print_malloc_stats (s, fp)
       totfree += v.nfree * v.blocksize;
       totused += v.nused * v.blocksize;
     }
+  totused += _mstats.tmmap;
   fprintf (fp, "\nTotal bytes in use: %lu, total bytes free: %lu\n",
 	   totused, totfree);
   fprintf (fp, "\nTotal bytes requested by application: %lu\n", _mstats.bytesreq);
@@ -117,6 +119,10 @@ _print_malloc_stats (s, fp)
   	   _mstats.nsbrk, _mstats.tsbrk);
   fprintf (fp, "Total blocks split: %d, total block coalesces: %d\n",
   	   _mstats.tbsplit, _mstats.tbcoalesce);
+  fprintf (fp, "Total mmaps: %d, munmaps: %d, mremaps: %d, bytes mapped: %lu\n",
+	   _mstats.nmmap, _mstats.nmunmap, _mstats.nmremap, _mstats.tmmap);
+  fprintf (fp, "Total madvises: %d, bytes given back via madvise: %lu\n",
+	   _mstats.nmadvise, _mstats.tmadvise);
 }
 
 void
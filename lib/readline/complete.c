@@ -121,10 +121,15 @@ static int append_to_match PARAMS((char *, int, int, int));
 static void insert_all_matches PARAMS((char **, int, char *));
 static int complete_fncmp PARAMS((const char *, int, const char *, int));
 static void display_matches PARAMS((char **));
+static void display_match_list PARAMS((char **, int, int));
 static int compute_lcd_of_matches PARAMS((char **, int, const char *));
 static int postprocess_matches PARAMS((char ***, int));
 static int complete_get_screenwidth PARAMS((void));
 
+static char **cached_matches PARAMS((rl_compentry_func_t *));
+static void cache_matches PARAMS((char **, rl_compentry_func_t *));
+static void commit_match_cache PARAMS((void));
+
 static char *make_quoted_replacement PARAMS((char *, int, char *));
 
 /* **************************************************************** */
@@ -363,6 +368,14 @@ int rl_completion_found_quote;
    preferences are honored. */
 int rl_completion_mark_symlink_dirs;
 
+/* If non-zero, the matches just generated may be listed or inserted again
+   by the next completion command without calling the completion functions,
+   as long as the line is unchanged.  rl_complete_internal sets this to 1
+   only if readline is doing filename completion on its own; an application
+   completion function may set it if the matches it generates don't depend
+   on rl_completion_type or on being called each time. */
+int rl_completion_reuse_matches;
+
 /* If non-zero, inhibit completion (temporarily). */
 int rl_inhibit_completion;
 
@@ -380,6 +393,35 @@ static int completion_changed_buffer;
 /* The result of the query to the user about displaying completion matches */
 static int completion_y_or_n;
 
+/* The matches from the last completion attempt, sorted and with the number
+   and widest display width of the matches filled in once they have been
+   displayed, along with what the completion functions set while generating
+   them.  If the attempt left the line alone, repeating the completion
+   command right away -- a second TAB to list the possibilities, say --
+   reuses the list rather than generating, sorting and measuring it again,
+   which is slow for directories with many thousands of files. */
+struct match_cache
+{
+  char **matches;
+  int len;			/* number of matches; 0 until measured */
+  int max;			/* widest match, as displayed */
+  rl_completion_func_t *attempted_func;
+  rl_compentry_func_t *entry_func;
+  int reusable;			/* rl_completion_reuse_matches */
+  char *line;			/* rl_line_buffer after the attempt */
+  int point;			/* rl_point after the attempt */
+  unsigned long keys;		/* rl_keys_read after the attempt */
+  /* What the completion functions set. */
+  int filename_desired;
+  int filename_quoting;
+  int suppress_append;
+  int suppress_quote;
+  int append_character;
+  int mark_symlink_dirs;
+};
+
+static struct match_cache match_cache;
+
 /*************************************/
 /*				     */
 /*    Bindable completion functions  */
@@ -472,6 +514,84 @@ set_completion_defaults (what_to_do)
 
   /* The completion entry function may optionally change this. */
   rl_completion_mark_symlink_dirs = _rl_complete_mark_symlink_dirs;
+
+  /* Application completion functions have to say their matches can be
+     reused. */
+  rl_completion_reuse_matches = (rl_attempted_completion_function == 0 &&
+				 rl_completion_entry_function == 0);
+}
+
+/* Return the matches from the last completion attempt if they are still
+   good: the completion functions said they could be reused, nothing but
+   the keys that invoked this command has been read since, the line and
+   point are the same, and the same functions would generate them.  The
+   settings the completion functions made are restored. */
+static char **
+cached_matches (entry_func)
+     rl_compentry_func_t *entry_func;
+{
+  if (match_cache.matches == 0 || match_cache.line == 0 ||
+      match_cache.reusable == 0)
+    return ((char **)NULL);
+  if (rl_keys_read - match_cache.keys != rl_key_sequence_length ||
+      match_cache.attempted_func != rl_attempted_completion_function ||
+      match_cache.entry_func != entry_func ||
+      match_cache.point != rl_point ||
+      STREQ (match_cache.line, rl_line_buffer) == 0)
+    return ((char **)NULL);
+
+  rl_filename_completion_desired = match_cache.filename_desired;
+  rl_filename_quoting_desired = match_cache.filename_quoting;
+  rl_completion_suppress_append = match_cache.suppress_append;
+  rl_completion_suppress_quote = match_cache.suppress_quote;
+  rl_completion_append_character = match_cache.append_character;
+  rl_completion_mark_symlink_dirs = match_cache.mark_symlink_dirs;
+
+  return (match_cache.matches);
+}
+
+/* Make MATCHES, just generated by ENTRY_FUNC, the cached list.  It is not
+   used again until commit_match_cache says the line is unchanged. */
+static void
+cache_matches (matches, entry_func)
+     char **matches;
+     rl_compentry_func_t *entry_func;
+{
+  _rl_free_match_cache ();
+
+  match_cache.matches = matches;
+  match_cache.len = match_cache.max = 0;
+  match_cache.attempted_func = rl_attempted_completion_function;
+  match_cache.entry_func = entry_func;
+  match_cache.reusable = rl_completion_reuse_matches;
+
+  match_cache.filename_desired = rl_filename_completion_desired;
+  match_cache.filename_quoting = rl_filename_quoting_desired;
+  match_cache.suppress_append = rl_completion_suppress_append;
+  match_cache.suppress_quote = rl_completion_suppress_quote;
+  match_cache.append_character = rl_completion_append_character;
+  match_cache.mark_symlink_dirs = rl_completion_mark_symlink_dirs;
+}
+
+/* Note the line, point and input position the cached list goes with. */
+static void
+commit_match_cache ()
+{
+  FREE (match_cache.line);
+  match_cache.line = savestring (rl_line_buffer);
+  match_cache.point = rl_point;
+  match_cache.keys = rl_keys_read;
+}
+
+/* Free the cached list of matches. */
+void
+_rl_free_match_cache ()
+{
+  if (match_cache.matches)
+    _rl_free_match_list (match_cache.matches);
+  FREE (match_cache.line);
+  match_cache.matches = (char **)NULL;
+  match_cache.line = (char *)NULL;
 }
 
 /* The user must press "y" or "n". Non-zero return means "y" pressed. */
@@ -725,7 +845,7 @@ fnprint (to_print, prefix_bytes)
 
       ellipsis = (to_print[prefix_bytes] == '.') ? '_' : '.';
       for (w = 0; w < ELLIPSIS_LEN; w++)
-	putc (ellipsis, rl_outstream);
+	_rl_output_character_function (ellipsis);
       printed_len = ELLIPSIS_LEN;
     }
 
@@ -734,8 +854,8 @@ fnprint (to_print, prefix_bytes)
     {
       if (CTRL_CHAR (*s))
         {
-          putc ('^', rl_outstream);
-          putc (UNCTRL (*s), rl_outstream);
+          _rl_output_character_function ('^');
+          _rl_output_character_function (UNCTRL (*s));
           printed_len += 2;
           s++;
 #if defined (HANDLE_MULTIBYTE)
@@ -744,8 +864,8 @@ fnprint (to_print, prefix_bytes)
         }
       else if (*s == RUBOUT)
 	{
-	  putc ('^', rl_outstream);
-	  putc ('?', rl_outstream);
+	  _rl_output_character_function ('^');
+	  _rl_output_character_function ('?');
 	  printed_len += 2;
 	  s++;
 #if defined (HANDLE_MULTIBYTE)
@@ -769,11 +889,11 @@ fnprint (to_print, prefix_bytes)
 	      w = wcwidth (wc);
 	      width = (w >= 0) ? w : 1;
 	    }
-	  fwrite (s, 1, tlen, rl_outstream);
+	  _rl_output_some_chars (s, tlen);
 	  s += tlen;
 	  printed_len += width;
 #else
-	  putc (*s, rl_outstream);
+	  _rl_output_character_function (*s);
 	  s++;
 	  printed_len++;
 #endif
@@ -869,7 +989,7 @@ print_filename (to_print, full_pathname, prefix_bytes)
       xfree (s);
       if (extension_char)
 	{
-	  putc (extension_char, rl_outstream);
+	  _rl_output_character_function (extension_char);
 	  printed_len++;
 	}
     }
@@ -1372,6 +1492,21 @@ void
 rl_display_match_list (matches, len, max)
      char **matches;
      int len, max;
+{
+  /* Sort the items if they are not already sorted. */
+  if (rl_ignore_completion_duplicates == 0 && rl_sort_completion_matches)
+    qsort (matches + 1, len, sizeof (char *), (QSFUNC *)_rl_qsort_string_compare);
+
+  display_match_list (matches, len, max);
+}
+
+/* Display the sorted list MATCHES.  The layout only needs LEN and MAX, so
+   each screenful is formatted as it is shown and sent to the terminal in
+   one write; if the user quits at the pager, the rest is never touched. */
+static void
+display_match_list (matches, len, max)
+     char **matches;
+     int len, max;
 {
   int count, limit, printed_len, lines, cols;
   int i, j, k, l, common_length, sind;
@@ -1416,10 +1551,7 @@ rl_display_match_list (matches, len, max)
      just do the inner printing loop.
 	   0 < len <= limit  implies  count = 1. */
 
-  /* Sort the items if they are not already sorted. */
-  if (rl_ignore_completion_duplicates == 0 && rl_sort_completion_matches)
-    qsort (matches + 1, len, sizeof (char *), (QSFUNC *)_rl_qsort_string_compare);
-
+  rl_begin_output ();
   rl_crlf ();
 
   lines = 0;
@@ -1439,7 +1571,7 @@ rl_display_match_list (matches, len, max)
 
 		  if (j + 1 < limit)
 		    for (k = 0; k < max - printed_len; k++)
-		      putc (' ', rl_outstream);
+		      _rl_output_character_function (' ');
 		}
 	      l += count;
 	    }
@@ -1447,9 +1579,11 @@ rl_display_match_list (matches, len, max)
 	  lines++;
 	  if (_rl_page_completions && lines >= (_rl_screenheight - 1) && i < count)
 	    {
+	      rl_end_output ();
 	      lines = _rl_internal_pager (lines);
 	      if (lines < 0)
 		return;
+	      rl_begin_output ();
 	    }
 	}
     }
@@ -1469,18 +1603,21 @@ rl_display_match_list (matches, len, max)
 		  lines++;
 		  if (_rl_page_completions && lines >= _rl_screenheight - 1)
 		    {
+		      rl_end_output ();
 		      lines = _rl_internal_pager (lines);
 		      if (lines < 0)
 			return;
+		      rl_begin_output ();
 		    }
 		}
 	      else
 		for (k = 0; k < max - printed_len; k++)
-		  putc (' ', rl_outstream);
+		  _rl_output_character_function (' ');
 	    }
 	}
       rl_crlf ();
     }
+  rl_end_output ();
 }
 
 /* Display MATCHES, a list of matching filenames in argv format.  This
@@ -1519,17 +1656,36 @@ display_matches (matches)
     }
 
   /* There is more than one answer.  Find out how many there are,
-     and find the maximum printed length of a single entry. */
-  for (max = 0, i = 1; matches[i]; i++)
+     and find the maximum printed length of a single entry.  A cached
+     list only needs this done the first time it is shown. */
+  if (matches == match_cache.matches && match_cache.len > 0)
     {
-      temp = printable_part (matches[i]);
-      len = fnwidth (temp);
-
-      if (len > max)
-	max = len;
+      len = match_cache.len;
+      max = match_cache.max;
     }
+  else
+    {
+      for (max = 0, i = 1; matches[i]; i++)
+	{
+	  temp = printable_part (matches[i]);
+	  len = fnwidth (temp);
+
+	  if (len > max)
+	    max = len;
+	}
+
+      len = i - 1;
 
-  len = i - 1;
+      /* Sort the items if they are not already sorted. */
+      if (rl_ignore_completion_duplicates == 0 && rl_sort_completion_matches)
+	qsort (matches + 1, len, sizeof (char *), (QSFUNC *)_rl_qsort_string_compare);
+
+      if (matches == match_cache.matches)
+	{
+	  match_cache.len = len;
+	  match_cache.max = max;
+	}
+    }
 
   /* If the caller has defined a display hook, then call that now. */
   if (rl_completion_display_matches_hook)
@@ -1556,7 +1712,7 @@ display_matches (matches)
 	}
     }
 
-  rl_display_match_list (matches, len, max);
+  display_match_list (matches, len, max);
 
   rl_forced_update_display ();
   rl_display_fixed = 1;
@@ -1796,7 +1952,7 @@ int
 rl_complete_internal (what_to_do)
      int what_to_do;
 {
-  char **matches;
+  char **matches, **cached;
   rl_compentry_func_t *our_func;
   int start, end, delimiter, found_quote, i, nontrivial_lcd;
   char *text, *saved_line_buffer;
@@ -1827,7 +1983,14 @@ rl_complete_internal (what_to_do)
   rl_point = end;
 
   text = rl_copy_text (start, end);
-  matches = gen_completion_matches (text, start, end, our_func, found_quote, quote_char);
+  cached = matches = cached_matches (our_func);
+  if (cached)
+    {
+      rl_completion_found_quote = found_quote;
+      rl_completion_quote_character = quote_char;
+    }
+  else
+    matches = gen_completion_matches (text, start, end, our_func, found_quote, quote_char);
   /* nontrivial_lcd is set if the common prefix adds something to the word
      being completed. */
   nontrivial_lcd = matches && strcmp (text, matches[0]) != 0;
@@ -1842,6 +2005,7 @@ rl_complete_internal (what_to_do)
       rl_ding ();
       FREE (saved_line_buffer);
       completion_changed_buffer = 0;
+      _rl_free_match_cache ();
       RL_UNSETSTATE(RL_STATE_COMPLETING);
       _rl_reset_completion_state ();
       return (0);
@@ -1852,16 +2016,22 @@ rl_complete_internal (what_to_do)
      rl_filename_completion_function does this. */
   i = rl_filename_completion_desired;
 
-  if (postprocess_matches (&matches, i) == 0)
+  if (cached == 0 && postprocess_matches (&matches, i) == 0)
     {
       rl_ding ();
       FREE (saved_line_buffer);
       completion_changed_buffer = 0;
+      _rl_free_match_cache ();
       RL_UNSETSTATE(RL_STATE_COMPLETING);
       _rl_reset_completion_state ();
       return (0);
     }
 
+  /* The cache owns the list from here on, even if it can't be reused, so
+     that it is freed the same way. */
+  if (cached == 0)
+    cache_matches (matches, our_func);
+
   switch (what_to_do)
     {
     case TAB:
@@ -1929,13 +2099,12 @@ rl_complete_internal (what_to_do)
       _rl_ttymsg ("bad value %d for what_to_do in rl_complete", what_to_do);
       rl_ding ();
       FREE (saved_line_buffer);
+      _rl_free_match_cache ();
       RL_UNSETSTATE(RL_STATE_COMPLETING);
       _rl_reset_completion_state ();
       return 1;
     }
 
-  _rl_free_match_list (matches);
-
   /* Check to see if the line has changed through all of this manipulation. */
   if (saved_line_buffer)
     {
@@ -1943,6 +2112,12 @@ rl_complete_internal (what_to_do)
       xfree (saved_line_buffer);
     }
 
+  /* Keep the matches for another try at the same line. */
+  if (completion_changed_buffer)
+    _rl_free_match_cache ();
+  else
+    commit_match_cache ();
+
   RL_UNSETSTATE(RL_STATE_COMPLETING);
   _rl_reset_completion_state ();
   return 0;
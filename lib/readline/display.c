@@ -514,6 +514,9 @@ rl_redisplay ()
   _rl_block_sigint ();  
   RL_SETSTATE (RL_STATE_REDISPLAYING);
 
+  /* Send the whole update to the terminal in one write. */
+  rl_begin_output ();
+
   if (!rl_display_prompt)
     rl_display_prompt = "";
 
@@ -1077,7 +1080,7 @@ rl_redisplay ()
 #endif
 	    {
 #if defined (__MSDOS__)
-	      putc ('\r', rl_outstream);
+	      _rl_output_character_function ('\r');
 #else
 	      if (_rl_term_cr)
 		tputs (_rl_term_cr, 1, _rl_output_character_function);
@@ -1226,7 +1229,7 @@ rl_redisplay ()
 	  last_lmargin = lmargin;
 	}
     }
-  fflush (rl_outstream);
+  rl_end_output ();
 
   /* Swap visible and non-visible lines. */
   {
@@ -1322,7 +1325,7 @@ update_line (old, new, current_line, omax, nmax, inv_botlin)
 	      int count, i;
 	      bytes = ret;
 	      for (count = 0; count < bytes; count++)
-		putc (new[count], rl_outstream);
+		_rl_output_character_function (new[count]);
 	      _rl_last_c_pos = tempwidth;
 	      _rl_last_v_pos++;
 	      memset (&ps, 0, sizeof (mbstate_t));
@@ -1341,7 +1344,7 @@ update_line (old, new, current_line, omax, nmax, inv_botlin)
 	    }
 	  else
 	    {
-	      putc (' ', rl_outstream);
+	      _rl_output_character_function (' ');
 	      _rl_last_c_pos = 1;
 	      _rl_last_v_pos++;
 	      if (old[0] && new[0])
@@ -1352,9 +1355,9 @@ update_line (old, new, current_line, omax, nmax, inv_botlin)
 #endif
 	{
 	  if (new[0])
-	    putc (new[0], rl_outstream);
+	    _rl_output_character_function (new[0]);
 	  else
-	    putc (' ', rl_outstream);
+	    _rl_output_character_function (' ');
 	  _rl_last_c_pos = 1;
 	  _rl_last_v_pos++;
 	  if (old[0] && new[0])
@@ -1519,7 +1522,7 @@ update_line (old, new, current_line, omax, nmax, inv_botlin)
       od >= lendiff && _rl_last_c_pos < PROMPT_ENDING_INDEX)
     {
 #if defined (__MSDOS__)
-      putc ('\r', rl_outstream);
+      _rl_output_character_function ('\r');
 #else
       tputs (_rl_term_cr, 1, _rl_output_character_function);
 #endif
@@ -1976,7 +1979,7 @@ _rl_move_cursor_relative (new, data)
       (_rl_term_autowrap && i == _rl_screenwidth))
     {
 #if defined (__MSDOS__)
-      putc ('\r', rl_outstream);
+      _rl_output_character_function ('\r');
 #else
       tputs (_rl_term_cr, 1, _rl_output_character_function);
 #endif /* !__MSDOS__ */
@@ -2013,12 +2016,12 @@ _rl_move_cursor_relative (new, data)
 	    {
 	      tputs (_rl_term_cr, 1, _rl_output_character_function);
 	      for (i = 0; i < new; i++)
-		putc (data[i], rl_outstream);
+		_rl_output_character_function (data[i]);
 	    }
 	}
       else
 	for (i = cpos; i < new; i++)
-	  putc (data[i], rl_outstream);
+	  _rl_output_character_function (data[i]);
     }
 
 #if defined (HANDLE_MULTIBYTE)
@@ -2046,9 +2049,9 @@ _rl_move_vert (to)
   if ((delta = to - _rl_last_v_pos) > 0)
     {
       for (i = 0; i < delta; i++)
-	putc ('\n', rl_outstream);
+	_rl_output_character_function ('\n');
 #if defined (__MSDOS__)
-      putc ('\r', rl_outstream);
+      _rl_output_character_function ('\r');
 #else
       tputs (_rl_term_cr, 1, _rl_output_character_function);
 #endif
@@ -2073,7 +2076,7 @@ rl_show_char (c)
   int n = 1;
   if (META_CHAR (c) && (_rl_output_meta_chars == 0))
     {
-      fprintf (rl_outstream, "M-");
+      _rl_output_some_chars ("M-", 2);
       n += 2;
       c = UNMETA (c);
     }
@@ -2084,12 +2087,12 @@ rl_show_char (c)
   if (CTRL_CHAR (c) || c == RUBOUT)
 #endif /* !DISPLAY_TABS */
     {
-      fprintf (rl_outstream, "C-");
+      _rl_output_some_chars ("C-", 2);
       n += 2;
       c = CTRL_CHAR (c) ? UNCTRL (c) : '?';
     }
 
-  putc (c, rl_outstream);
+  _rl_output_character_function (c);
   fflush (rl_outstream);
   return n;
 }
@@ -2305,7 +2308,7 @@ _rl_erase_at_end_of_line (l)
 
   _rl_backspace (l);
   for (i = 0; i < l; i++)
-    putc (' ', rl_outstream);
+    _rl_output_character_function (' ');
   _rl_backspace (l);
   for (i = 0; i < l; i++)
     visible_line[--_rl_last_c_pos] = '\0';
@@ -2333,7 +2336,7 @@ space_to_eol (count)
   register int i;
 
   for (i = 0; i < count; i++)
-   putc (' ', rl_outstream);
+   _rl_output_character_function (' ');
 
   _rl_last_c_pos += count;
 }
@@ -2426,6 +2429,7 @@ _rl_update_final ()
 {
   int full_lines;
 
+  rl_begin_output ();
   full_lines = 0;
   /* If the cursor is the only thing on an otherwise-blank last line,
      compensate so we don't print an extra CRLF. */
@@ -2445,11 +2449,11 @@ _rl_update_final ()
       cpos_buffer_position = -1;	/* don't know where we are in buffer */
       _rl_move_cursor_relative (_rl_screenwidth - 1, last_line);	/* XXX */
       _rl_clear_to_eol (0);
-      putc (last_line[_rl_screenwidth - 1], rl_outstream);
+      _rl_output_character_function (last_line[_rl_screenwidth - 1]);
     }
   _rl_vis_botlin = 0;
   rl_crlf ();
-  fflush (rl_outstream);
+  rl_end_output ();
   rl_display_fixed++;
 }
 
@@ -2460,7 +2464,7 @@ cr ()
   if (_rl_term_cr)
     {
 #if defined (__MSDOS__)
-      putc ('\r', rl_outstream);
+      _rl_output_character_function ('\r');
 #else
       tputs (_rl_term_cr, 1, _rl_output_character_function);
 #endif
@@ -2504,19 +2508,20 @@ _rl_redisplay_after_sigwinch ()
      either more or fewer characters on that line only) and put the cursor at
      column 0.  Make sure the right thing happens if we have wrapped to a new
      screen line. */
+  rl_begin_output ();
   if (_rl_term_cr)
     {
       _rl_move_vert (_rl_vis_botlin);
 
 #if defined (__MSDOS__)
-      putc ('\r', rl_outstream);
+      _rl_output_character_function ('\r');
 #else
       tputs (_rl_term_cr, 1, _rl_output_character_function);
 #endif
       _rl_last_c_pos = 0;
 #if defined (__MSDOS__)
       space_to_eol (_rl_screenwidth);
-      putc ('\r', rl_outstream);
+      _rl_output_character_function ('\r');
 #else
       if (_rl_term_clreol)
 	tputs (_rl_term_clreol, 1, _rl_output_character_function);
@@ -2538,6 +2543,7 @@ _rl_redisplay_after_sigwinch ()
     redraw_prompt (++t);
   else
     rl_forced_update_display ();
+  rl_end_output ();
 }
 
 void
@@ -2555,10 +2561,11 @@ _rl_clean_up_for_exit ()
 void
 _rl_erase_entire_line ()
 {
+  rl_begin_output ();
   cr ();
   _rl_clear_to_eol (0);
   cr ();
-  fflush (rl_outstream);
+  rl_end_output ();
 }
 
 /* return the `current display line' of the cursor -- the number of lines to
@@ -102,6 +102,30 @@ extern int errno;
 /* If non-zero, we write timestamps to the history file in history_do_write() */
 int history_write_timestamps = 0;
 
+/* Non-zero means that when a history file is read into an empty history
+   list, the entries are left in a copy of the file and only read from it
+   when they are first used. */
+int history_lazy_load = 0;
+
+/* The number of entries at the front of the history list that are still
+   to be read from lazy_buffer.  Entry N starts at lazy_index[lazy_first+N],
+   at its timestamp line if it has one. */
+int _hs_lazy_length = 0;
+
+static char *lazy_buffer;	/* contents of the history file */
+static size_t lazy_bufsize;	/* if mapped, for munmap */
+static char *lazy_bufend;
+static char **lazy_index;
+static int lazy_first;
+static char *lazy_time;		/* timestamp for entries without one */
+
+static char *history_skip_entries PARAMS((char *, char *, int, int *));
+static int history_index_entries PARAMS((char *, char *, char **, char **));
+static int history_read_lazily PARAMS((char *, size_t, char *, char *, char **));
+static void history_lazy_free PARAMS((void));
+static int history_do_read PARAMS((const char *, int, int, off_t *, off_t));
+static int history_lock_file PARAMS((int, const char *, int));
+
 /* Does S look like the beginning of a history timestamp entry?  Placeholder
    for more extensive tests. */
 #define HIST_TIMESTAMP_START(s)		(*(s) == history_comment_char && isdigit ((s)[1]) )
@@ -167,12 +191,235 @@ int
 read_history_range (filename, from, to)
      const char *filename;
      int from, to;
+{
+  return (history_do_read (filename, from, to, (off_t *)NULL, -1));
+}
+
+/* Read the lines in FILENAME that start at byte offset *OFFSETP and end
+   before byte offset END (or at the end of the file, if END is negative),
+   and add them to the history list.  If *OFFSETP is negative, or past
+   the end of the file, start at the FROM'th line instead.  On return,
+   *OFFSETP is the offset just past the last complete history entry
+   read, which can be passed to a later call to read only the lines that
+   have been appended to the file since.  Returns 0 or errno. */
+int
+read_history_offset (filename, from, offsetp, end)
+     const char *filename;
+     int from;
+     off_t *offsetp, end;
+{
+  return (history_do_read (filename, from, -1, offsetp, end));
+}
+
+/* Walk the lines between START and END, the way history_do_read adds
+   them to the history list.  If N is non-negative, return the start of
+   the N'th history entry (counting from zero), or of the timestamp line
+   preceding it.  Otherwise, store the number of entries in *COUNTP and
+   return END. */
+static char *
+history_skip_entries (start, end, n, countp)
+     char *start, *end;
+     int n, *countp;
+{
+  char *line, *next, *ts;
+  int count;
+
+  for (count = 0, ts = 0, line = start; line < end; line = next)
+    {
+      next = (char *)memchr (line, '\n', end - line);
+      if (next == 0)
+	break;
+      next++;
+
+      if (HIST_TIMESTAMP_START (line))
+	ts = line;
+      else if (*line != '\n' && (*line != '\r' || next - line > 2))
+	{
+	  if (count == n)
+	    return (ts ? ts : line);
+	  count++;
+	  ts = 0;
+	}
+    }
+
+  if (countp)
+    *countp = count;
+  return end;
+}
+
+/* Store the start of each history entry between START and END in INDEX,
+   the way history_skip_entries counts them, and return the number of
+   entries.  If RESTP is non-null, set it to the first character that is
+   not part of a complete entry: a timestamp line with no entry after it,
+   or a partial last line. */
+static int
+history_index_entries (start, end, index, restp)
+     char *start, *end, **index, **restp;
+{
+  char *line, *next, *ts;
+  int count;
+
+  for (count = 0, ts = 0, line = start; line < end; line = next)
+    {
+      next = (char *)memchr (line, '\n', end - line);
+      if (next == 0)
+	break;
+      next++;
+
+      if (HIST_TIMESTAMP_START (line))
+	ts = line;
+      else if (*line != '\n' && (*line != '\r' || next - line > 2))
+	{
+	  if (index)
+	    index[count] = ts ? ts : line;
+	  count++;
+	  ts = 0;
+	}
+    }
+
+  if (restp)
+    *restp = ts ? ts : line;
+  return count;
+}
+
+/* Add the entries between START and END in BUFFER, which holds the
+   contents of a history file, to the empty history list without reading
+   them.  BUFSIZE is the size of BUFFER, which munmap needs if it's mapped.
+   Returns the number of entries added; if there were any, the history
+   library now owns BUFFER, and *RESTP is set as history_index_entries
+   sets it. */
+static int
+history_read_lazily (buffer, bufsize, start, end, restp)
+     char *buffer, *start, *end, **restp;
+     size_t bufsize;
+{
+  char ts[64], *rest;
+  int count;
+
+  count = history_index_entries (start, end, (char **)NULL, &rest);
+  if (count == 0)
+    return 0;
+  *restp = rest;
+
+  _hs_lazy_keep (0);
+  lazy_index = (char **)xmalloc (count * sizeof (char *));
+  history_index_entries (start, end, lazy_index, (char **)NULL);
+  lazy_buffer = buffer;
+  lazy_bufsize = bufsize;
+  lazy_bufend = end;
+  lazy_first = 0;
+
+  /* Entries read from a file without timestamps get the time they were
+     read, as add_history would give them. */
+#if defined (HAVE_VSNPRINTF)		/* assume snprintf if vsnprintf exists */
+  snprintf (ts, sizeof (ts) - 1, "X%lu", (unsigned long) time ((time_t *)0));
+#else
+  sprintf (ts, "X%lu", (unsigned long) time ((time_t *)0));
+#endif
+  lazy_time = savestring (ts);
+  lazy_time[0] = history_comment_char;
+
+  _hs_lazy_length = count;
+  _hs_add_unread (count);
+  return count;
+}
+
+/* Make a history entry from the WHICH'th of the entries at the front of
+   the history list that haven't been read yet. */
+HIST_ENTRY *
+_hs_lazy_entry (which)
+     int which;
+{
+  char *line, *eol, *ts;
+  int len;
+  HIST_ENTRY *ent;
+
+  ts = (char *)NULL;
+  line = lazy_index[lazy_first + which];
+  if (HIST_TIMESTAMP_START (line))
+    {
+      eol = (char *)memchr (line, '\n', lazy_bufend - line);
+      len = (eol > line && eol[-1] == '\r') ? eol - line - 1 : eol - line;
+      ts = (char *)xmalloc (len + 1);
+      strncpy (ts, line, len);
+      ts[len] = '\0';
+
+      /* Skip the empty lines history_index_entries skipped. */
+      for (line = eol + 1; *line == '\n' || (*line == '\r' && line[1] == '\n'); )
+	line += (*line == '\n') ? 1 : 2;
+    }
+
+  eol = (char *)memchr (line, '\n', lazy_bufend - line);
+  len = (eol > line && eol[-1] == '\r') ? eol - line - 1 : eol - line;
+
+  ent = (HIST_ENTRY *)xmalloc (sizeof (HIST_ENTRY));
+  ent->line = (char *)xmalloc (len + 1);
+  strncpy (ent->line, line, len);
+  ent->line[len] = '\0';
+  ent->timestamp = ts ? ts : savestring (lazy_time);
+  ent->data = (histdata_t)NULL;
+
+  return ent;
+}
+
+/* N entries have been removed from the front of the history list. */
+void
+_hs_lazy_drop (n)
+     int n;
+{
+  lazy_first += n;
+  _hs_lazy_length -= n;
+  if (_hs_lazy_length <= 0)
+    history_lazy_free ();
+}
+
+/* Only the first N entries in the history list are still to be read;
+   the rest have been read or removed. */
+void
+_hs_lazy_keep (n)
+     int n;
+{
+  if (n < _hs_lazy_length)
+    _hs_lazy_length = n;
+  if (_hs_lazy_length <= 0)
+    history_lazy_free ();
+}
+
+static void
+history_lazy_free ()
+{
+  if (lazy_buffer)
+    {
+#ifdef HISTORY_USE_MMAP
+      munmap (lazy_buffer, lazy_bufsize);
+#else
+      free (lazy_buffer);
+#endif
+    }
+  FREE (lazy_index);
+  FREE (lazy_time);
+  lazy_buffer = lazy_bufend = lazy_time = (char *)NULL;
+  lazy_index = (char **)NULL;
+  lazy_bufsize = 0;
+  lazy_first = _hs_lazy_length = 0;
+}
+
+/* Workhorse function for reading history.  Reads lines FROM through TO
+   from FILENAME, or, if OFFSETP is non-null and a valid offset into the
+   file, the lines between *OFFSETP and END.  Leaves *OFFSETP just past
+   the last entry read. */
+static int
+history_do_read (filename, from, to, offsetp, end)
+     const char *filename;
+     int from, to;
+     off_t *offsetp, end;
 {
   register char *line_start, *line_end, *p;
-  char *input, *buffer, *bufend, *last_ts;
+  char *input, *buffer, *bufstart, *bufend, *last_ts, *rest;
   int file, current_line, chars_read;
   struct stat finfo;
   size_t file_size;
+  off_t start;
 #if defined (EFBIG)
   int overflow_errno = EFBIG;
 #elif defined (EOVERFLOW)
@@ -197,6 +444,19 @@ read_history_range (filename, from, to)
       goto error_and_exit;
     }
 
+  /* A valid offset means we are picking up where an earlier read left
+     off, so there are no lines to skip. */
+  start = 0;
+  if (offsetp && *offsetp >= 0 && *offsetp <= finfo.st_size)
+    {
+      start = *offsetp;
+      from = 0;
+    }
+  if (end < 0 || end > finfo.st_size)
+    end = finfo.st_size;
+  if (end < start)
+    end = start;
+
 #ifdef HISTORY_USE_MMAP
   /* We map read/write and private so we can change newlines to NULs without
      affecting the underlying object. */
@@ -206,16 +466,21 @@ read_history_range (filename, from, to)
       errno = overflow_errno;
       goto error_and_exit;
     }
-  chars_read = file_size;
+  bufstart = buffer + start;
+  chars_read = end - start;
 #else
-  buffer = (char *)malloc (file_size + 1);
+  buffer = (char *)malloc (end - start + 1);
   if (buffer == 0)
     {
       errno = overflow_errno;
       goto error_and_exit;
     }
 
-  chars_read = read (file, buffer, file_size);
+  if (start > 0 && lseek (file, start, SEEK_SET) < 0)
+    chars_read = -1;
+  else
+    chars_read = read (file, buffer, end - start);
+  bufstart = buffer;
 #endif
   if (chars_read < 0)
     {
@@ -242,11 +507,11 @@ read_history_range (filename, from, to)
     to = chars_read;
 
   /* Start at beginning of file, work to end. */
-  bufend = buffer + chars_read;
+  bufend = bufstart + chars_read;
   current_line = 0;
 
   /* Skip lines until we are at FROM. */
-  for (line_start = line_end = buffer; line_end < bufend && current_line < from; line_end++)
+  for (line_start = line_end = bufstart; line_end < bufend && current_line < from; line_end++)
     if (*line_end == '\n')
       {
       	p = line_end + 1;
@@ -257,6 +522,34 @@ read_history_range (filename, from, to)
 	line_start = p;
       }
 
+  /* If the history list is stifled, any entries in excess of the maximum
+     would be added only to be dropped again, perhaps many thousands of
+     them when the file is much larger than the list.  Don't allocate
+     those; count them instead, so history_base ends up where it would
+     have been. */
+  if (history_max_entries > 0 && history_is_stifled () && to >= chars_read)
+    {
+      int nentries, nskip;
+
+      history_skip_entries (line_start, bufend, -1, &nentries);
+      nskip = nentries - history_max_entries;
+      if (nskip > 0)
+	{
+	  line_start = history_skip_entries (line_start, bufend, nskip, (int *)NULL);
+	  history_base += nskip;
+	}
+    }
+
+  /* When the whole file is being read into an empty history list, just
+     note where each entry starts, and leave reading them until they're
+     used.  Most of the history list is usually never looked at. */
+  if (history_lazy_load && history_length == 0 && to >= chars_read &&
+      history_read_lazily (buffer, file_size, line_start, bufend, &rest))
+    {
+      buffer = (char *)NULL;
+      line_start = bufend = rest;
+    }
+
   /* If there are lines left to gobble, then gobble them now. */
   for (line_end = line_start; line_end < bufend; line_end++)
     if (*line_end == '\n')
@@ -287,22 +580,67 @@ read_history_range (filename, from, to)
 
 	current_line++;
 
+	line_start = line_end + 1;
 	if (current_line >= to)
 	  break;
-
-	line_start = line_end + 1;
       }
 
+  /* Leave the offset before a partial last line or a timestamp whose
+     history entry has not been written yet, so the next read sees them
+     whole. */
+  if (offsetp)
+    *offsetp = start + ((last_ts ? last_ts : line_start) - bufstart);
+
   FREE (input);
 #ifndef HISTORY_USE_MMAP
   FREE (buffer);
 #else
-  munmap (buffer, file_size);
+  if (buffer)
+    munmap (buffer, file_size);
 #endif
 
   return (0);
 }
 
+/* Return a pointer to the start of the history entry LINES entries from
+   the end of BUFFER, which holds NCHARS characters of a history file, or
+   BUFFER itself if it holds no more than LINES entries. */
+static char *
+history_tail_start (buffer, nchars, lines)
+     char *buffer;
+     int nchars, lines;
+{
+  char *bp, *bp1;		/* bp1 == bp+1 */
+
+  /* Count backwards from the end of buffer until we have passed
+     LINES lines.  bp1 is set funny initially.  But since bp[1] can't
+     be a comment character (since it's off the end) and *bp can't be
+     both a newline and the history comment character, it should be OK. */
+  for (bp1 = bp = buffer + nchars - 1; lines && bp > buffer; bp--)
+    {
+      if (*bp == '\n' && HIST_TIMESTAMP_START(bp1) == 0)
+	lines--;
+      bp1 = bp;
+    }
+
+  /* If this is the first line, then the file contains exactly the
+     number of lines we want to truncate to, so we don't need to do
+     anything.  It's the first line if we don't find a newline between
+     the current value of i and 0.  Otherwise, return the start of
+     this line. */
+  for ( ; bp > buffer; bp--)
+    {
+      if (*bp == '\n' && HIST_TIMESTAMP_START(bp1) == 0)
+        {
+	  bp++;
+	  break;
+        }
+      bp1 = bp;
+    }
+
+  return (bp > buffer ? bp : buffer);
+}
+
 /* Truncate the history file FNAME, leaving only LINES trailing lines.
    If FNAME is NULL, then use ~/.history.  Returns 0 on success, errno
    on failure. */
@@ -311,7 +649,7 @@ history_truncate_file (fname, lines)
      const char *fname;
      int lines;
 {
-  char *buffer, *filename, *bp, *bp1;		/* bp1 == bp+1 */
+  char *buffer, *filename, *bp;
   int file, chars_read, rv;
   struct stat finfo;
   size_t file_size;
@@ -373,31 +711,7 @@ history_truncate_file (fname, lines)
       goto truncate_exit;
     }
 
-  /* Count backwards from the end of buffer until we have passed
-     LINES lines.  bp1 is set funny initially.  But since bp[1] can't
-     be a comment character (since it's off the end) and *bp can't be
-     both a newline and the history comment character, it should be OK. */
-  for (bp1 = bp = buffer + chars_read - 1; lines && bp > buffer; bp--)
-    {
-      if (*bp == '\n' && HIST_TIMESTAMP_START(bp1) == 0)
-	lines--;
-      bp1 = bp;
-    }
-
-  /* If this is the first line, then the file contains exactly the
-     number of lines we want to truncate to, so we don't need to do
-     anything.  It's the first line if we don't find a newline between
-     the current value of i and 0.  Otherwise, write from the start of
-     this line until the end of the buffer. */
-  for ( ; bp > buffer; bp--)
-    {
-      if (*bp == '\n' && HIST_TIMESTAMP_START(bp1) == 0)
-        {
-	  bp++;
-	  break;
-        }
-      bp1 = bp;
-    }
+  bp = history_tail_start (buffer, chars_read, lines);
 
   /* Write only if there are more lines in the file than we want to
      truncate to. */
@@ -421,13 +735,195 @@ history_truncate_file (fname, lines)
   return rv;
 }
 
+/* Wait for a lock on all of FD, which is open on FILENAME, so that
+   history_compact_file and the processes appending to a history file
+   don't get in each other's way.  If FILENAME no longer names the file FD
+   is open on once we have the lock, history_compact_file replaced it while
+   we waited; nobody reads the old file any more, so open FILENAME again
+   with FLAGS and lock that instead.  Returns the locked descriptor, or -1
+   if FILENAME can't be opened again.  If the file can't be locked, FD is
+   returned anyway and used without a lock, as it always was before. */
+static int
+history_lock_file (fd, filename, flags)
+     int fd;
+     const char *filename;
+     int flags;
+{
+#if defined (F_SETLKW)
+  struct flock fl;
+  struct stat fsb, nsb;
+
+  while (1)
+    {
+      fl.l_type = F_WRLCK;
+      fl.l_whence = SEEK_SET;
+      fl.l_start = fl.l_len = 0;
+      if (fcntl (fd, F_SETLKW, &fl) < 0)
+	return fd;
+
+      if (fstat (fd, &fsb) < 0 || stat (filename, &nsb) < 0 ||
+	  (fsb.st_dev == nsb.st_dev && fsb.st_ino == nsb.st_ino))
+	return fd;
+
+      close (fd);
+      if ((fd = open (filename, flags, 0600)) < 0)
+	return -1;
+    }
+#else
+  return fd;
+#endif
+}
+
+/* Copy everything left to read on FD to TFD, using BUFFER, which holds
+   BUFSIZE characters.  Returns 0 or errno. */
+static int
+history_copy_rest (fd, tfd, buffer, bufsize)
+     int fd, tfd;
+     char *buffer;
+     size_t bufsize;
+{
+  ssize_t nr;
+
+  while ((nr = read (fd, buffer, bufsize)) > 0)
+    if (write (tfd, buffer, nr) != nr)
+      return (errno ? errno : EIO);
+  return (nr < 0 ? errno : 0);
+}
+
+/* Truncate the history file FNAME to its last LINES lines, like
+   history_truncate_file, but without losing lines that other processes
+   append to FNAME while we work.  Instead of rewriting FNAME in place,
+   copy the trailing lines and anything appended after them to a new file
+   and rename it to FNAME.  Both files stay locked until the copy is
+   finished, so processes appending with history_do_write wait and then
+   append to the new file.  If REMOVEDP is non-null, *REMOVEDP is set to
+   the number of bytes discarded from the front of the file, so callers
+   can adjust offsets they have saved.  Returns 0 on success, errno on
+   failure. */
+int
+history_compact_file (fname, lines, removedp)
+     const char *fname;
+     int lines;
+     off_t *removedp;
+{
+  char *buffer, *filename, *tempname, *bp;
+  int file, tfile, chars_read, rv;
+  struct stat finfo;
+  size_t file_size;
+
+  if (removedp)
+    *removedp = 0;
+
+  buffer = tempname = (char *)NULL;
+  filename = history_filename (fname);
+  file = filename ? open (filename, O_RDWR|O_BINARY, 0666) : -1;
+  if (file != -1)
+    file = history_lock_file (file, filename, O_RDWR|O_BINARY);
+  tfile = -1;
+  rv = 0;
+
+  if (file == -1 || fstat (file, &finfo) == -1)
+    {
+      rv = errno;
+      goto compact_exit;
+    }
+
+  if (S_ISREG (finfo.st_mode) == 0)
+    {
+#ifdef EFTYPE
+      rv = EFTYPE;
+#else
+      rv = EINVAL;
+#endif
+      goto compact_exit;
+    }
+
+  file_size = (size_t)finfo.st_size;
+  if (file_size != finfo.st_size || file_size + 1 < file_size)
+    {
+#if defined (EFBIG)
+      rv = EFBIG;
+#elif defined (EOVERFLOW)
+      rv = EOVERFLOW;
+#else
+      rv = EINVAL;
+#endif
+      goto compact_exit;
+    }
+
+  buffer = (char *)malloc (file_size + 1);
+  if (buffer == 0)
+    {
+      rv = errno;
+      goto compact_exit;
+    }
+
+  chars_read = read (file, buffer, file_size);
+  if (chars_read <= 0)
+    {
+      rv = (chars_read < 0) ? errno : 0;
+      goto compact_exit;
+    }
+
+  bp = history_tail_start (buffer, chars_read, lines);
+  if (bp == buffer)
+    goto compact_exit;
+
+  /* Other processes only ever append to the file, so opening the new one
+     for appending as well keeps the lines we copy after the rename from
+     overwriting theirs. */
+  tempname = (char *)xmalloc (strlen (filename) + 32);
+  sprintf (tempname, "%s-%ld.tmp", filename, (long)getpid ());
+  tfile = open (tempname, O_WRONLY|O_CREAT|O_EXCL|O_APPEND|O_BINARY, 0600);
+  if (tfile != -1)
+    tfile = history_lock_file (tfile, tempname, O_WRONLY|O_APPEND|O_BINARY);
+  if (tfile == -1)
+    {
+      rv = errno;
+      goto compact_exit;
+    }
+  chmod (tempname, finfo.st_mode & 07777);
+
+  if (write (tfile, bp, chars_read - (bp - buffer)) != chars_read - (bp - buffer) ||
+	(rv = history_copy_rest (file, tfile, buffer, file_size)) != 0 ||
+	rename (tempname, filename) < 0)
+    {
+      if (rv == 0)
+	rv = errno ? errno : EIO;
+      unlink (tempname);
+      goto compact_exit;
+    }
+
+  /* Pick up anything appended to the old file between the last read
+     and the rename.  Nothing more can be appended to it: we hold its lock,
+     and whoever gets it next will find it replaced. */
+  history_copy_rest (file, tfile, buffer, file_size);
+
+  if (removedp)
+    *removedp = bp - buffer;
+
+ compact_exit:
+
+  if (file != -1)
+    close (file);
+  if (tfile != -1)
+    close (tfile);
+  FREE (buffer);
+  FREE (tempname);
+  FREE (filename);
+  return rv;
+}
+
 /* Workhorse function for writing history.  Writes NELEMENT entries
    from the history list to FILENAME.  OVERWRITE is non-zero if you
-   wish to replace FILENAME with the entries. */
+   wish to replace FILENAME with the entries.  If RANGEP is non-null,
+   RANGEP[0] and RANGEP[1] are set to the offsets in FILENAME where the
+   entries start and end. */
 static int
-history_do_write (filename, nelements, overwrite)
+history_do_write (filename, nelements, overwrite, rangep)
      const char *filename;
      int nelements, overwrite;
+     off_t *rangep;
 {
   register int i;
   char *output;
@@ -441,6 +937,8 @@ history_do_write (filename, nelements, overwrite)
 #endif
   output = history_filename (filename);
   file = output ? open (output, mode, 0600) : -1;
+  if (file != -1 && overwrite == 0)
+    file = history_lock_file (file, output, mode);
   rv = 0;
 
   if (file == -1)
@@ -459,21 +957,23 @@ history_do_write (filename, nelements, overwrite)
   /* Build a buffer of all the lines to write, and write them in one syscall.
      Suggested by Peter Ho (peter@robosts.oxford.ac.uk). */
   {
-    HIST_ENTRY **the_history;	/* local */
+    HIST_ENTRY *hent;
     register int j;
     int buffer_size;
     char *buffer;
 
-    the_history = history_list ();
-    /* Calculate the total number of bytes to write. */
+    /* Calculate the total number of bytes to write.  Only the entries
+       being written are read from the history file, if they haven't been
+       already. */
     for (buffer_size = 0, i = history_length - nelements; i < history_length; i++)
 #if 0
-      buffer_size += 2 + HISTENT_BYTES (the_history[i]);
+      buffer_size += 2 + HISTENT_BYTES (_hs_history_entry (i));
 #else
       {
-	if (history_write_timestamps && the_history[i]->timestamp && the_history[i]->timestamp[0])
-	  buffer_size += strlen (the_history[i]->timestamp) + 1;
-	buffer_size += strlen (the_history[i]->line) + 1;
+	hent = _hs_history_entry (i);
+	if (history_write_timestamps && hent->timestamp && hent->timestamp[0])
+	  buffer_size += strlen (hent->timestamp) + 1;
+	buffer_size += strlen (hent->line) + 1;
       }
 #endif
 
@@ -503,23 +1003,38 @@ mmap_error:
 
     for (j = 0, i = history_length - nelements; i < history_length; i++)
       {
-	if (history_write_timestamps && the_history[i]->timestamp && the_history[i]->timestamp[0])
+	hent = _hs_history_entry (i);
+	if (history_write_timestamps && hent->timestamp && hent->timestamp[0])
 	  {
-	    strcpy (buffer + j, the_history[i]->timestamp);
-	    j += strlen (the_history[i]->timestamp);
+	    strcpy (buffer + j, hent->timestamp);
+	    j += strlen (hent->timestamp);
 	    buffer[j++] = '\n';
 	  }
-	strcpy (buffer + j, the_history[i]->line);
-	j += strlen (the_history[i]->line);
+	strcpy (buffer + j, hent->line);
+	j += strlen (hent->line);
 	buffer[j++] = '\n';
       }
 
 #ifdef HISTORY_USE_MMAP
     if (msync (buffer, buffer_size, 0) != 0 || munmap (buffer, buffer_size) != 0)
       rv = errno;
+    else if (rangep)
+      {
+	rangep[0] = cursize;
+	rangep[1] = cursize + buffer_size;
+      }
 #else
+    /* Since the file is opened for appending, the kernel places the
+       entire buffer at the end of the file, even if other processes are
+       appending to it at the same time, and leaves the file offset just
+       past it. */
     if (write (file, buffer, buffer_size) < 0)
       rv = errno;
+    else if (rangep)
+      {
+	rangep[1] = lseek (file, 0, SEEK_CUR);
+	rangep[0] = rangep[1] - buffer_size;
+      }
     xfree (buffer);
 #endif
   }
@@ -538,7 +1053,30 @@ append_history (nelements, filename)
      int nelements;
      const char *filename;
 {
-  return (history_do_write (filename, nelements, HISTORY_APPEND));
+  return (history_do_write (filename, nelements, HISTORY_APPEND, (off_t *)NULL));
+}
+
+/* Append NELEMENT entries to FILENAME, as append_history does, and set
+   *STARTP and *ENDP to the offsets in FILENAME at which the appended
+   entries begin and end.  Other processes may have appended to the file
+   since it was last read, so *STARTP is not necessarily the previous
+   end of file. */
+int
+append_history_offset (nelements, filename, startp, endp)
+     int nelements;
+     const char *filename;
+     off_t *startp, *endp;
+{
+  off_t range[2];
+  int r;
+
+  range[0] = range[1] = -1;
+  r = history_do_write (filename, nelements, HISTORY_APPEND, range);
+  if (startp)
+    *startp = range[0];
+  if (endp)
+    *endp = range[1];
+  return r;
 }
 
 /* Overwrite FILENAME with the current history.  If FILENAME is NULL,
@@ -548,5 +1086,5 @@ int
 write_history (filename)
      const char *filename;
 {
-  return (history_do_write (filename, history_length, HISTORY_OVERWRITE));
+  return (history_do_write (filename, history_length, HISTORY_OVERWRITE, (off_t *)NULL));
 }
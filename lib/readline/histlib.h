@@ -79,4 +79,20 @@ extern char *strchr ();
 /* Some variable definitions shared across history source files. */
 extern int history_offset;
 
+/* history.c */
+extern HIST_ENTRY *_hs_history_entry PARAMS((int));
+extern void _hs_add_unread PARAMS((int));
+
+/* histfile.c */
+extern int _hs_lazy_length;
+extern HIST_ENTRY *_hs_lazy_entry PARAMS((int));
+extern void _hs_lazy_drop PARAMS((int));
+extern void _hs_lazy_keep PARAMS((int));
+
+/* histsearch.c */
+extern void _hs_index_flush PARAMS((void));
+extern void _hs_index_update PARAMS((int, const char *));
+extern void _hs_index_drop PARAMS((int));
+extern int _hs_search_next PARAMS((const char *, int, int, int));
+
 #endif /* !_HISTLIB_H_ */
@@ -52,6 +52,9 @@
 #define DEFAULT_HISTORY_GROW_SIZE 50
 
 static char *hist_inittime PARAMS((void));
+static void history_materialize PARAMS((int));
+static void history_pack PARAMS((void));
+static void history_grow PARAMS((void));
 
 /* **************************************************************** */
 /*								    */
@@ -62,11 +65,16 @@ static char *hist_inittime PARAMS((void));
 /* An array of HIST_ENTRY.  This is where we store the history. */
 static HIST_ENTRY **the_history = (HIST_ENTRY **)NULL;
 
+/* The space allocated for the_history.  Entries removed from the front of
+   a stifled history leave unused slots between here and the_history. */
+static HIST_ENTRY **history_buffer = (HIST_ENTRY **)NULL;
+
 /* Non-zero means that we have enforced a limit on the amount of
    history that we save. */
 static int history_stifled;
 
-/* The current number of slots allocated to the input_history. */
+/* The current number of slots allocated to the input_history, counting
+   from the_history. */
 static int history_size;
 
 /* If HISTORY_STIFLED is non-zero, then this is the maximum number of
@@ -90,6 +98,9 @@ history_get_history_state ()
 {
   HISTORY_STATE *state;
 
+  history_materialize (0);
+  history_pack ();
+
   state = (HISTORY_STATE *)xmalloc (sizeof (HISTORY_STATE));
   state->entries = the_history;
   state->offset = history_offset;
@@ -107,12 +118,14 @@ void
 history_set_history_state (state)
      HISTORY_STATE *state;
 {
-  the_history = state->entries;
+  history_materialize (0);
+  the_history = history_buffer = state->entries;
   history_offset = state->offset;
   history_length = state->length;
   history_size = state->size;
   if (state->flags & HS_STIFLED)
     history_stifled = 1;
+  _hs_index_flush ();
 }
 
 /* Begin a session in which the history functions might be used.  This
@@ -131,8 +144,8 @@ history_total_bytes ()
 {
   register int i, result;
 
-  for (i = result = 0; the_history && the_history[i]; i++)
-    result += HISTENT_BYTES (the_history[i]);
+  for (i = result = 0; the_history && i < history_length; i++)
+    result += HISTENT_BYTES (_hs_history_entry (i));
 
   return (result);
 }
@@ -159,13 +172,64 @@ history_set_pos (pos)
  
 /* Return the current history array.  The caller has to be careful, since this
    is the actual array of data, and could be bashed or made corrupt easily.
-   The array is terminated with a NULL pointer. */
+   The array is terminated with a NULL pointer.  Callers walk the array
+   directly, so every entry not yet read from the history file is read
+   now. */
 HIST_ENTRY **
 history_list ()
 {
+  history_materialize (0);
   return (the_history);
 }
 
+/* Return the entry at offset WHICH in the history list, which must be
+   valid, reading it from the history file if that hasn't been done yet. */
+HIST_ENTRY *
+_hs_history_entry (which)
+     int which;
+{
+  if (the_history[which] == 0 && which < _hs_lazy_length)
+    the_history[which] = _hs_lazy_entry (which);
+  return (the_history[which]);
+}
+
+/* Read the entries from offset FROM up to the end of those that haven't
+   been read from the history file yet, so only the ones before FROM are
+   left unread. */
+static void
+history_materialize (from)
+     int from;
+{
+  register int i;
+
+  if (from >= _hs_lazy_length)
+    return;
+  for (i = from; i < _hs_lazy_length; i++)
+    _hs_history_entry (i);
+  _hs_lazy_keep (from);
+}
+
+/* Add COUNT entries to the empty history list without reading them from
+   the history file.  Their slots stay NULL until they are first used. */
+void
+_hs_add_unread (count)
+     int count;
+{
+  register int i;
+
+  history_pack ();
+  if (history_size < count + 1)
+    {
+      history_size = count + DEFAULT_HISTORY_GROW_SIZE;
+      the_history = history_buffer = (HIST_ENTRY **)
+	xrealloc (history_buffer, history_size * sizeof (HIST_ENTRY *));
+    }
+  for (i = 0; i <= count; i++)
+    the_history[i] = (HIST_ENTRY *)NULL;
+  history_length = count;
+  _hs_index_flush ();
+}
+
 /* Return the history entry at the current position, as determined by
    history_offset.  If there is no entry there, return a NULL pointer. */
 HIST_ENTRY *
@@ -173,7 +237,7 @@ current_history ()
 {
   return ((history_offset == history_length) || the_history == 0)
 		? (HIST_ENTRY *)NULL
-		: the_history[history_offset];
+		: _hs_history_entry (history_offset);
 }
 
 /* Back up history_offset to the previous history entry, and return
@@ -182,7 +246,7 @@ current_history ()
 HIST_ENTRY *
 previous_history ()
 {
-  return history_offset ? the_history[--history_offset] : (HIST_ENTRY *)NULL;
+  return history_offset ? _hs_history_entry (--history_offset) : (HIST_ENTRY *)NULL;
 }
 
 /* Move history_offset forward to the next history entry, and return
@@ -191,7 +255,7 @@ previous_history ()
 HIST_ENTRY *
 next_history ()
 {
-  return (history_offset == history_length) ? (HIST_ENTRY *)NULL : the_history[++history_offset];
+  return (history_offset == history_length) ? (HIST_ENTRY *)NULL : _hs_history_entry (++history_offset);
 }
 
 /* Return the history entry which is logically at OFFSET in the history array.
@@ -205,7 +269,7 @@ history_get (offset)
   local_index = offset - history_base;
   return (local_index >= history_length || local_index < 0 || the_history == 0)
 		? (HIST_ENTRY *)NULL
-		: the_history[local_index];
+		: _hs_history_entry (local_index);
 }
 
 HIST_ENTRY *
@@ -258,6 +322,49 @@ hist_inittime ()
   return ret;
 }
 
+/* Move the history list back to the start of history_buffer, reclaiming
+   the slots left by entries removed from the front. */
+static void
+history_pack ()
+{
+  int slack;
+
+  slack = the_history - history_buffer;
+  if (slack == 0)
+    return;
+
+  memmove (history_buffer, the_history, (history_length + 1) * sizeof (HIST_ENTRY *));
+  the_history = history_buffer;
+  history_size += slack;
+}
+
+/* Make room at the end of the_history for another entry and the NULL that
+   terminates the list.  The slots left at the front of history_buffer by
+   a stifled history are reused once there are at least as many of them as
+   there are entries, so the cost of moving the list is spread over that
+   many calls to add_history.  Otherwise the buffer grows in proportion to
+   the number of entries. */
+static void
+history_grow ()
+{
+  int slack, grow;
+
+  slack = the_history - history_buffer;
+  if (slack > 0 && slack >= history_length)
+    {
+      history_pack ();
+      if (history_length + 2 <= history_size)
+	return;
+    }
+
+  slack = the_history - history_buffer;
+  grow = (history_length > DEFAULT_HISTORY_GROW_SIZE) ? history_length : DEFAULT_HISTORY_GROW_SIZE;
+  history_size += grow;
+  history_buffer = (HIST_ENTRY **)
+    xrealloc (history_buffer, (slack + history_size) * sizeof (HIST_ENTRY *));
+  the_history = history_buffer + slack;
+}
+
 /* Place STRING at the end of the history list.  The data field
    is  set to NULL. */
 void
@@ -268,8 +375,6 @@ add_history (string)
 
   if (history_stifled && (history_length == history_max_entries))
     {
-      register int i;
-
       /* If the history is stifled, and history_length is zero,
 	 and it equals history_max_entries, we don't save items. */
       if (history_length == 0)
@@ -279,36 +384,37 @@ add_history (string)
       if (the_history[0])
 	(void) free_history_entry (the_history[0]);
 
-      /* Copy the rest of the entries, moving down one slot. */
-      for (i = 0; i < history_length; i++)
-	the_history[i] = the_history[i + 1];
+      /* Drop the oldest entry by starting the list one slot later in
+	 history_buffer instead of copying the rest of the entries down. */
+      the_history++;
+      history_size--;
+      history_length--;
+      _hs_index_drop (1);
+      if (_hs_lazy_length)
+	_hs_lazy_drop (1);
 
       history_base++;
     }
+
+  if (history_size == 0)
+    {
+      history_size = DEFAULT_HISTORY_GROW_SIZE;
+      the_history = history_buffer = (HIST_ENTRY **)xmalloc (history_size * sizeof (HIST_ENTRY *));
+      history_length = 1;
+    }
   else
     {
-      if (history_size == 0)
-	{
-	  history_size = DEFAULT_HISTORY_GROW_SIZE;
-	  the_history = (HIST_ENTRY **)xmalloc (history_size * sizeof (HIST_ENTRY *));
-	  history_length = 1;
-	}
-      else
-	{
-	  if (history_length == (history_size - 1))
-	    {
-	      history_size += DEFAULT_HISTORY_GROW_SIZE;
-	      the_history = (HIST_ENTRY **)
-		xrealloc (the_history, history_size * sizeof (HIST_ENTRY *));
-	    }
-	  history_length++;
-	}
+      if (history_length + 2 > history_size)
+	history_grow ();
+      history_length++;
     }
 
   temp = alloc_history_entry (string, hist_inittime ());
 
   the_history[history_length] = (HIST_ENTRY *)NULL;
   the_history[history_length - 1] = temp;
+
+  _hs_index_update (history_length - 1, temp->line);
 }
 
 /* Change the time stamp of the most recent history entry to STRING. */
@@ -320,7 +426,7 @@ add_history_time (string)
 
   if (string == 0)
     return;
-  hs = the_history[history_length - 1];
+  hs = _hs_history_entry (history_length - 1);
   FREE (hs->timestamp);
   hs->timestamp = savestring (string);
 }
@@ -377,13 +483,15 @@ replace_history_entry (which, line, data)
     return ((HIST_ENTRY *)NULL);
 
   temp = (HIST_ENTRY *)xmalloc (sizeof (HIST_ENTRY));
-  old_value = the_history[which];
+  old_value = _hs_history_entry (which);
 
   temp->line = savestring (line);
   temp->data = data;
   temp->timestamp = savestring (old_value->timestamp);
   the_history[which] = temp;
 
+  _hs_index_update (which, temp->line);
+
   return (old_value);
 }
 
@@ -404,6 +512,11 @@ replace_history_data (which,old, new)
   if (which < -2 || which >= history_length || history_length == 0 || the_history == 0)
     return;
 
+  /* Entries not yet read from the history file have no data, so they
+     only need to be read if they match. */
+  if (old == 0 && new != 0)
+    history_materialize (0);
+
   if (which >= 0)
     {
       entry = the_history[which];
@@ -445,13 +558,28 @@ remove_history (which)
   if (which < 0 || which >= history_length || history_length ==  0 || the_history == 0)
     return ((HIST_ENTRY *)NULL);
 
-  return_value = the_history[which];
+  /* The entries still to be read from the history file have to stay at
+     the front of the list, with none removed from between them. */
+  if (which > 0)
+    history_materialize (which);
+  return_value = _hs_history_entry (which);
 
   for (i = which; i < history_length; i++)
     the_history[i] = the_history[i + 1];
 
   history_length--;
 
+  /* Removing the first entry is the only change that doesn't renumber the
+     entries as far as the search index is concerned. */
+  if (which == 0)
+    {
+      _hs_index_drop (1);
+      if (_hs_lazy_length)
+	_hs_lazy_drop (1);
+    }
+  else
+    _hs_index_flush ();
+
   return (return_value);
 }
 
@@ -472,10 +600,12 @@ stifle_history (max)
 	free_history_entry (the_history[i]);
 
       history_base = i;
-      for (j = 0, i = history_length - max; j < max; i++, j++)
-	the_history[j] = the_history[i];
-      the_history[j] = (HIST_ENTRY *)NULL;
-      history_length = j;
+      the_history += j;
+      history_size -= j;
+      history_length = max;
+      _hs_index_drop (j);
+      if (_hs_lazy_length)
+	_hs_lazy_drop (j);
     }
 
   history_stifled = 1;
@@ -516,4 +646,7 @@ clear_history ()
     }
 
   history_offset = history_length = 0;
+  history_pack ();
+  _hs_index_flush ();
+  _hs_lazy_keep (0);
 }
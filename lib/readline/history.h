@@ -26,6 +26,7 @@
 extern "C" {
 #endif
 
+#include <sys/types.h>		/* for off_t */
 #include <time.h>		/* XXX - for history timestamp code */
 
 #if defined READLINE_LIBRARY
@@ -192,6 +193,12 @@ extern int read_history PARAMS((const char *));
    ~/.history.  Returns 0 if successful, or errno if not. */
 extern int read_history_range PARAMS((const char *, int, int));
 
+/* Read the lines in FILENAME starting at byte offset *OFFSETP (or, if
+   that is negative, at line FROM) and ending before byte offset END
+   (or at end of file, if END is negative).  Leaves *OFFSETP just past
+   the last line read.  Returns 0 on success, or errno. */
+extern int read_history_offset PARAMS((const char *, int, off_t *, off_t));
+
 /* Write the current history to FILENAME.  If FILENAME is NULL,
    then write the history list to ~/.history.  Values returned
    are as in read_history ().  */
@@ -201,9 +208,21 @@ extern int write_history PARAMS((const char *));
    the end of the list minus NELEMENTs up to the end of the list. */
 extern int append_history PARAMS((int, const char *));
 
+/* Append the last N lines of history to FILENAME, as append_history()
+   does, storing the byte offsets where they start and end in the last
+   two arguments. */
+extern int append_history_offset PARAMS((int, const char *, off_t *, off_t *));
+
 /* Truncate the history file, leaving only the last NLINES lines. */
 extern int history_truncate_file PARAMS((const char *, int));
 
+/* Truncate the history file to the last N lines by writing them to a new
+   file and renaming it, keeping any lines other processes append in the
+   meantime.  The number of bytes removed from the front of the file is
+   stored through the last argument.  Returns 0 on success, errno on
+   failure. */
+extern int history_compact_file PARAMS((const char *, int, off_t *));
+
 /* History expansion. */
 
 /* Expand the string STRING, placing the result into OUTPUT, a pointer
@@ -250,6 +269,9 @@ extern char *history_search_delimiter_chars;
 extern int history_quotes_inhibit_expansion;
 
 extern int history_write_timestamps;
+extern int history_lazy_load;
+
+extern int history_search_index;
 
 /* Backwards compatibility */
 extern int max_input_history;
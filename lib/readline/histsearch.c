@@ -41,13 +41,51 @@
 
 #include "history.h"
 #include "histlib.h"
+#include "xmalloc.h"
 
 /* The list of alternate characters that can delimit a history search
    string. */
 char *history_search_delimiter_chars = (char *)NULL;
 
+/* Non-zero means to keep an index of the three-character substrings of the
+   history entries, so searches only have to look at the entries that
+   contain all of the search string's three-character substrings. */
+int history_search_index = 0;
+
 static int history_search_internal PARAMS((const char *, int, int));
 
+/* The index maps each trigram (three consecutive bytes) to the serial
+   numbers of the history entries that contain it, in increasing order.
+   An entry's serial number is its offset in the history list plus the
+   serial number of the first entry, which goes up as entries are removed
+   from the front of the list, so those removals don't change the index.
+   The lists may contain entries that no longer contain the trigram, since
+   entries are only ever added to them; searches check each candidate. */
+typedef struct hist_trigram {
+  int key;			/* the three bytes, or -1 for an empty slot */
+  int len, size;
+  int *serials;
+} HIST_TRIGRAM;
+
+static HIST_TRIGRAM *hindex_table;	/* open-addressed hash table */
+static int hindex_size;			/* always a power of two */
+static int hindex_used;
+static int hindex_valid;	/* non-zero if the index matches the history */
+static int hindex_first;	/* serial number of the first history entry */
+static int hindex_dropped;	/* entries removed from the front since built */
+
+#define HINDEX_INITIAL_SIZE	4096
+
+#define TRIGRAM(s)	((((unsigned char)(s)[0]) << 16) | (((unsigned char)(s)[1]) << 8) | ((unsigned char)(s)[2]))
+#define TRIGRAM_HASH(k)	(((unsigned int)(k) * 2654435761U) >> 8)
+
+static HIST_TRIGRAM *hindex_lookup PARAMS((int, int));
+static void hindex_grow PARAMS((void));
+static void hindex_add_line PARAMS((const char *, int));
+static int hindex_build PARAMS((void));
+static int hindex_find PARAMS((HIST_TRIGRAM *, int));
+static int hindex_contains PARAMS((HIST_TRIGRAM *, int));
+
 /* Search the history for STRING, starting at history_offset.
    If DIRECTION < 0, then the search is through previous entries, else
    through subsequent.  If ANCHORED is non-zero, the string must
@@ -67,7 +105,6 @@ history_search_internal (string, direction, anchored)
   register char *line;
   register int line_index;
   int string_len;
-  HIST_ENTRY **the_history; 	/* local */
 
   i = history_offset;
   reverse = (direction < 0);
@@ -84,17 +121,18 @@ history_search_internal (string, direction, anchored)
 
 #define NEXT_LINE() do { if (reverse) i--; else i++; } while (0)
 
-  the_history = history_list ();
   string_len = strlen (string);
   while (1)
     {
-      /* Search each line in the history list for STRING. */
+      /* Search each line in the history list for STRING, skipping the
+	 ones the index says can't contain it. */
+      i = _hs_search_next (string, string_len, i, direction);
 
       /* At limit for direction? */
       if ((reverse && i < 0) || (!reverse && i == history_length))
 	return (-1);
 
-      line = the_history[i]->line;
+      line = _hs_history_entry (i)->line;
       line_index = strlen (line);
 
       /* If STRING is longer than line, no match. */
@@ -192,3 +230,268 @@ history_search_pos (string, dir, pos)
   history_set_pos (old);
   return ret;
 }
+
+/* **************************************************************** */
+/*								    */
+/*			History Search Index			    */
+/*								    */
+/* **************************************************************** */
+
+/* Return the index entry for trigram KEY.  If CREATE is non-zero, add an
+   empty one if it's not there; otherwise return NULL. */
+static HIST_TRIGRAM *
+hindex_lookup (key, create)
+     int key, create;
+{
+  register unsigned int i, mask;
+
+  mask = hindex_size - 1;
+  for (i = TRIGRAM_HASH (key) & mask; hindex_table[i].key != -1; i = (i + 1) & mask)
+    if (hindex_table[i].key == key)
+      return (&hindex_table[i]);
+
+  if (create == 0)
+    return ((HIST_TRIGRAM *)NULL);
+
+  if (2 * (hindex_used + 1) > hindex_size)
+    {
+      hindex_grow ();
+      return (hindex_lookup (key, create));
+    }
+
+  hindex_used++;
+  hindex_table[i].key = key;
+  hindex_table[i].len = hindex_table[i].size = 0;
+  hindex_table[i].serials = (int *)NULL;
+  return (&hindex_table[i]);
+}
+
+/* Double the size of the index hash table. */
+static void
+hindex_grow ()
+{
+  HIST_TRIGRAM *old;
+  int i, osize;
+  unsigned int j, mask;
+
+  old = hindex_table;
+  osize = hindex_size;
+
+  hindex_size = osize ? osize * 2 : HINDEX_INITIAL_SIZE;
+  hindex_table = (HIST_TRIGRAM *)xmalloc (hindex_size * sizeof (HIST_TRIGRAM));
+  for (i = 0; i < hindex_size; i++)
+    hindex_table[i].key = -1;
+
+  mask = hindex_size - 1;
+  for (i = 0; i < osize; i++)
+    {
+      if (old[i].key == -1)
+	continue;
+      for (j = TRIGRAM_HASH (old[i].key) & mask; hindex_table[j].key != -1; j = (j + 1) & mask)
+	;
+      hindex_table[j] = old[i];
+    }
+  FREE (old);
+}
+
+/* Add SERIAL to the lists for each trigram in LINE. */
+static void
+hindex_add_line (line, serial)
+     const char *line;
+     int serial;
+{
+  HIST_TRIGRAM *t;
+  const char *s;
+  int i;
+
+  if (line == 0 || line[0] == 0 || line[1] == 0)
+    return;
+
+  for (s = line; s[2]; s++)
+    {
+      t = hindex_lookup (TRIGRAM (s), 1);
+      if (t->len && t->serials[t->len - 1] >= serial)
+	{
+	  /* Not appending: a replaced entry, or a repeated trigram. */
+	  i = hindex_find (t, serial);
+	  if (i < t->len && t->serials[i] == serial)
+	    continue;
+	}
+      else
+	i = t->len;
+
+      if (t->len == t->size)
+	{
+	  t->size = t->size ? t->size * 2 : 4;
+	  t->serials = (int *)xrealloc (t->serials, t->size * sizeof (int));
+	}
+      if (i < t->len)
+	memmove (t->serials + i + 1, t->serials + i, (t->len - i) * sizeof (int));
+      t->serials[i] = serial;
+      t->len++;
+    }
+}
+
+/* Build the index if necessary.  Returns non-zero if it can be used. */
+static int
+hindex_build ()
+{
+  int i;
+
+  if (history_search_index == 0)
+    {
+      _hs_index_flush ();
+      return 0;
+    }
+  if (hindex_valid)
+    return 1;
+
+  _hs_index_flush ();
+  hindex_grow ();
+  hindex_first = hindex_dropped = 0;
+
+  for (i = 0; i < history_length; i++)
+    hindex_add_line (_hs_history_entry (i)->line, i);
+
+  hindex_valid = 1;
+  return 1;
+}
+
+/* Return the offset of the first element of T's list that is not less
+   than SERIAL, or T->len if there isn't one. */
+static int
+hindex_find (t, serial)
+     HIST_TRIGRAM *t;
+     int serial;
+{
+  int lo, hi, mid;
+
+  lo = 0;
+  hi = t->len;
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (t->serials[mid] < serial)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return lo;
+}
+
+static int
+hindex_contains (t, serial)
+     HIST_TRIGRAM *t;
+     int serial;
+{
+  int i;
+
+  i = hindex_find (t, serial);
+  return (i < t->len && t->serials[i] == serial);
+}
+
+/* Throw away the search index; it will be rebuilt the next time it's
+   needed.  Called when entries are removed from the middle of the history
+   list, which changes the positions of the entries after them. */
+void
+_hs_index_flush ()
+{
+  register int i;
+
+  for (i = 0; i < hindex_size; i++)
+    if (hindex_table[i].key != -1)
+      FREE (hindex_table[i].serials);
+  FREE (hindex_table);
+  hindex_table = (HIST_TRIGRAM *)NULL;
+  hindex_size = hindex_used = 0;
+  hindex_valid = 0;
+}
+
+/* The history entry at offset WHICH has been added or has had its line
+   replaced with LINE. */
+void
+_hs_index_update (which, line)
+     int which;
+     const char *line;
+{
+  if (hindex_valid == 0)
+    return;
+  if (history_search_index == 0)
+    _hs_index_flush ();
+  else
+    hindex_add_line (line, hindex_first + which);
+}
+
+/* N entries have been removed from the front of the history list.  Once
+   the lists hold more serial numbers of removed entries than of current
+   ones, it's time to rebuild the index. */
+void
+_hs_index_drop (n)
+     int n;
+{
+  if (hindex_valid == 0)
+    return;
+  hindex_first += n;
+  hindex_dropped += n;
+  if (hindex_dropped > history_length)
+    _hs_index_flush ();
+}
+
+/* Return the offset of the first history entry at or after WHICH, going
+   forward if DIR is positive and backward if it's negative, that might
+   contain the first LEN bytes of STRING.  Returns -1 or history_length if
+   there are no such entries.  Without an index, or if STRING is too short
+   to use it, that's WHICH itself. */
+int
+_hs_search_next (string, len, which, dir)
+     const char *string;
+     int len, which, dir;
+{
+  HIST_TRIGRAM **tri, *rare;
+  int i, j, serial, ntri, ret;
+
+  if (len < 3 || which < 0 || which >= history_length || hindex_build () == 0)
+    return which;
+
+  ret = (dir < 0) ? -1 : history_length;
+
+  /* Look through the list of the least common trigram in STRING, checking
+     each entry on it against the lists for the others. */
+  ntri = len - 2;
+  tri = (HIST_TRIGRAM **)xmalloc (ntri * sizeof (HIST_TRIGRAM *));
+  rare = (HIST_TRIGRAM *)NULL;
+  for (i = 0; i < ntri; i++)
+    {
+      tri[i] = hindex_lookup (TRIGRAM (string + i), 0);
+      if (tri[i] == 0 || tri[i]->len == 0)
+	{
+	  xfree (tri);
+	  return ret;
+	}
+      if (rare == 0 || tri[i]->len < rare->len)
+	rare = tri[i];
+    }
+
+  serial = hindex_first + which;
+  i = hindex_find (rare, serial);
+  if (dir < 0 && (i == rare->len || rare->serials[i] != serial))
+    i--;
+
+  for ( ; i >= 0 && i < rare->len; i += (dir < 0) ? -1 : 1)
+    {
+      serial = rare->serials[i];
+      if (serial < hindex_first)
+	break;
+      for (j = 0; j < ntri; j++)
+	if (tri[j] != rare && hindex_contains (tri[j], serial) == 0)
+	  break;
+      if (j == ntri)
+	{
+	  ret = serial - hindex_first;
+	  break;
+	}
+    }
+
+  xfree (tri);
+  return ret;
+}
@@ -405,6 +405,9 @@ rl_clear_pending_input ()
 /*								    */
 /* **************************************************************** */
 
+/* The number of keys read, for measuring what a keystroke costs. */
+unsigned long rl_keys_read = 0;
+
 /* Read a key, including pending input. */
 int
 rl_read_key ()
@@ -412,6 +415,7 @@ rl_read_key ()
   int c, r;
 
   rl_key_sequence_length++;
+  rl_keys_read++;
 
   if (rl_pending_input)
     {
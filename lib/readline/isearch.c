@@ -50,6 +50,7 @@
 
 #include "readline.h"
 #include "history.h"
+#include "histlib.h"
 
 #include "rlprivate.h"
 #include "xmalloc.h"
@@ -577,8 +578,11 @@ _rl_isearch_dispatch (cxt, c)
 	 searching for. */
       do
 	{
-	  /* Move to the next line. */
+	  /* Move to the next line, skipping history entries the search
+	     index says can't contain the search string. */
 	  cxt->history_pos += cxt->direction;
+	  if (cxt->history_pos >= 0 && cxt->history_pos < cxt->hlen - 1 && cxt->hlen - 1 == history_length)
+	    cxt->history_pos = _hs_search_next (cxt->search_string, cxt->search_string_index, cxt->history_pos, cxt->direction);
 
 	  /* At limit for direction? */
 	  if ((cxt->sflags & SF_REVERSE) ? (cxt->history_pos < 0) : (cxt->history_pos == cxt->hlen))
@@ -437,6 +437,9 @@ readline_internal_teardown (eof)
   if (rl_undo_list)
     rl_free_undo_list ();
 
+  /* Nor will the matches from the last completion be used again. */
+  _rl_free_match_cache ();
+
   /* Restore normal cursor, if available. */
   _rl_set_insert_mode (RL_IM_INSERT, 0);
 
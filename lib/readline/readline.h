@@ -375,6 +375,12 @@ extern int rl_clear_message PARAMS((void));
 extern int rl_reset_line_state PARAMS((void));
 extern int rl_crlf PARAMS((void));
 
+/* Collecting terminal output so that it is written all at once. */
+extern void rl_begin_output PARAMS((void));
+extern void rl_end_output PARAMS((void));
+extern int rl_output_char PARAMS((int));
+extern void rl_output_chars PARAMS((const char *, int));
+
 #if defined (USE_VARARGS) && defined (PREFER_STDARG)
 extern int rl_message (const char *, ...)  __attribute__((__format__ (printf, 1, 2)));
 #else
@@ -520,6 +526,12 @@ extern int rl_done;
 /* If set to a character value, that will be the next keystroke read. */
 extern int rl_pending_input;
 
+/* The number of keys read, and the number of bytes and writes it took to
+   update the terminal. */
+extern unsigned long rl_keys_read;
+extern unsigned long rl_output_bytes;
+extern unsigned long rl_output_writes;
+
 /* Non-zero if we called this function from _rl_dispatch().  It's present
    so functions can find out whether they were called from a key binding
    or directly from an application. */
@@ -789,6 +801,14 @@ extern int rl_sort_completion_matches;
    preferences are honored. */
 extern int rl_completion_mark_symlink_dirs;
 
+/* If non-zero, the matches just generated may be listed or inserted again
+   by the next completion command without calling the completion functions,
+   as long as the line is unchanged.  rl_complete_internal sets this to 1
+   only if readline is doing filename completion on its own; an application
+   completion function may set it if the matches it generates don't depend
+   on rl_completion_type or on being called each time. */
+extern int rl_completion_reuse_matches;
+
 /* If non-zero, then disallow duplicates in the matches. */
 extern int rl_ignore_completion_duplicates;
 
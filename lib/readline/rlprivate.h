@@ -245,6 +245,7 @@ extern void _rl_callback_data_dispose PARAMS((_rl_callback_generic_arg *));
 extern void _rl_reset_completion_state PARAMS((void));
 extern char _rl_find_completion_word PARAMS((int *, int *));
 extern void _rl_free_match_list PARAMS((char **));
+extern void _rl_free_match_cache PARAMS((void));
 
 /* display.c */
 extern char *_rl_strip_prompt PARAMS((char *));
@@ -337,6 +338,7 @@ extern void _rl_output_character_function PARAMS((int));
 extern int _rl_output_character_function PARAMS((int));
 #endif
 extern void _rl_output_some_chars PARAMS((const char *, int));
+extern void _rl_flush_output PARAMS((void));
 extern int _rl_backspace PARAMS((int));
 extern void _rl_enable_meta_key PARAMS((void));
 extern void _rl_control_keypad PARAMS((int));
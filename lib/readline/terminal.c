@@ -77,6 +77,9 @@ static void _win_get_screensize PARAMS((int *, int *));
 static void _emx_get_screensize PARAMS((int *, int *));
 #endif
 
+static void output_append PARAMS((const char *, int));
+static void output_capability PARAMS((char *));
+
 #define CUSTOM_REDISPLAY_FUNC() (rl_redisplay_function != rl_redisplay)
 #define CUSTOM_INPUT_FUNC() (rl_getc_function != rl_getc)
 
@@ -595,12 +598,105 @@ rl_reset_terminal (terminal_name)
   return 0;
 }
 
+/* **************************************************************** */
+/*								    */
+/*		    Collecting Terminal Output			    */
+/*								    */
+/* **************************************************************** */
+
+/* While a batch is open, output is collected here instead of being
+   written to _rl_out_stream a character or a string at a time, and the
+   whole batch goes out in one write when the outermost batch is closed.
+   Redisplay opens a batch, so a keystroke costs one write. */
+static char *output_buffer = (char *)NULL;
+static size_t output_buffer_size = 0;
+static size_t output_buffer_len = 0;
+static int output_batch_depth = 0;
+
+/* The number of bytes readline has written to the terminal and the number
+   of writes it took.  Together with rl_keys_read, these give the cost of
+   a keystroke. */
+unsigned long rl_output_bytes = 0;
+unsigned long rl_output_writes = 0;
+
+static void
+output_append (string, count)
+     const char *string;
+     int count;
+{
+  if (output_buffer_len + count > output_buffer_size)
+    {
+      output_buffer_size = (output_buffer_len + count + 256) & ~255;
+      output_buffer = (char *)xrealloc (output_buffer, output_buffer_size);
+    }
+  memcpy (output_buffer + output_buffer_len, string, count);
+  output_buffer_len += count;
+}
+
+/* Open a batch of output. */
+void
+rl_begin_output ()
+{
+  output_batch_depth++;
+}
+
+/* Close a batch of output, writing it if it is the outermost one. */
+void
+rl_end_output ()
+{
+  if (output_batch_depth > 0 && --output_batch_depth == 0)
+    _rl_flush_output ();
+}
+
+/* Write any output collected so far and flush the output stream. */
+void
+_rl_flush_output ()
+{
+  if (output_buffer_len > 0)
+    {
+      fwrite (output_buffer, 1, output_buffer_len, _rl_out_stream);
+      rl_output_bytes += output_buffer_len;
+      rl_output_writes++;
+      output_buffer_len = 0;
+    }
+  fflush (_rl_out_stream);
+}
+
+/* Write C to the terminal.  For applications that draw on the screen
+   around readline and want their output batched with its own. */
+int
+rl_output_char (c)
+     int c;
+{
+  _rl_output_character_function (c);
+  return c;
+}
+
+/* Write COUNT characters from STRING to the terminal. */
+void
+rl_output_chars (string, count)
+     const char *string;
+     int count;
+{
+  _rl_output_some_chars (string, count);
+}
+
 /* A function for the use of tputs () */
 #ifdef _MINIX
 void
 _rl_output_character_function (c)
      int c;
 {
+  char ch;
+
+  if (output_batch_depth)
+    {
+      ch = c;
+      output_append (&ch, 1);
+      return;
+    }
+  rl_output_bytes++;
+  rl_output_writes++;
   putc (c, _rl_out_stream);
 }
 #else /* !_MINIX */
@@ -608,6 +704,16 @@ int
 _rl_output_character_function (c)
      int c;
 {
+  char ch;
+
+  if (output_batch_depth)
+    {
+      ch = c;
+      output_append (&ch, 1);
+      return c;
+    }
+  rl_output_bytes++;
+  rl_output_writes++;
   return putc (c, _rl_out_stream);
 }
 #endif /* !_MINIX */
@@ -618,9 +724,28 @@ _rl_output_some_chars (string, count)
      const char *string;
      int count;
 {
+  if (count <= 0)
+    return;
+  if (output_batch_depth)
+    {
+      output_append (string, count);
+      return;
+    }
+  rl_output_bytes += count;
+  rl_output_writes++;
   fwrite (string, 1, count, _rl_out_stream);
 }
 
+/* Send the capability string CAP to the terminal in one write. */
+static void
+output_capability (cap)
+     char *cap;
+{
+  rl_begin_output ();
+  tputs (cap, 1, _rl_output_character_function);
+  rl_end_output ();
+}
+
 /* Move the cursor back. */
 int
 _rl_backspace (count)
@@ -628,12 +753,14 @@ _rl_backspace (count)
 {
   register int i;
 
+  rl_begin_output ();
   if (_rl_term_backspace)
     for (i = 0; i < count; i++)
       tputs (_rl_term_backspace, 1, _rl_output_character_function);
   else
     for (i = 0; i < count; i++)
-      putc ('\b', _rl_out_stream);
+      _rl_output_character_function ('\b');
+  rl_end_output ();
   return 0;
 }
 
@@ -645,7 +772,7 @@ rl_crlf ()
   if (_rl_term_cr)
     tputs (_rl_term_cr, 1, _rl_output_character_function);
 #endif /* NEW_TTY_DRIVER || __MINT__ */
-  putc ('\n', _rl_out_stream);
+  _rl_output_character_function ('\n');
   return 0;
 }
 
@@ -663,7 +790,7 @@ rl_ding ()
 	case VISIBLE_BELL:
 	  if (_rl_visible_bell)
 	    {
-	      tputs (_rl_visible_bell, 1, _rl_output_character_function);
+	      output_capability (_rl_visible_bell);
 	      break;
 	    }
 	  /* FALLTHROUGH */
@@ -688,7 +815,7 @@ _rl_enable_meta_key ()
 {
 #if !defined (__DJGPP__)
   if (term_has_meta && _rl_term_mm)
-    tputs (_rl_term_mm, 1, _rl_output_character_function);
+    output_capability (_rl_term_mm);
 #endif
 }
 
@@ -698,9 +825,9 @@ _rl_control_keypad (on)
 {
 #if !defined (__DJGPP__)
   if (on && _rl_term_ks)
-    tputs (_rl_term_ks, 1, _rl_output_character_function);
+    output_capability (_rl_term_ks);
   else if (!on && _rl_term_ke)
-    tputs (_rl_term_ke, 1, _rl_output_character_function);
+    output_capability (_rl_term_ke);
 #endif
 }
 
@@ -723,9 +850,9 @@ _rl_set_cursor (im, force)
       if (force || im != rl_insert_mode)
 	{
 	  if (im == RL_IM_OVERWRITE)
-	    tputs (_rl_term_vs, 1, _rl_output_character_function);
+	    output_capability (_rl_term_vs);
 	  else
-	    tputs (_rl_term_ve, 1, _rl_output_character_function);
+	    output_capability (_rl_term_ve);
 	}
     }
 }
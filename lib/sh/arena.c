@@ -0,0 +1,176 @@
+/* arena.c - scoped storage for short-lived expansion temporaries. */
+
+/* Copyright (C) 2011 Free Software Foundation, Inc.
+
+   This file is part of GNU Bash, the Bourne Again SHell.
+
+   Bash is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Bash is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Bash.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* The arena hands out storage by bumping a pointer through a chain of
+   blocks.  Nothing allocated from it is freed individually; instead the
+   shell takes a mark before executing a command and releases everything
+   allocated since that mark when the command completes.  Marks nest, so a
+   command run while another is being expanded (a trap, say) releases only
+   its own storage.  Nothing allocated from the arena may be kept past the
+   command it was allocated for. */
+
+#include <config.h>
+
+#include <bashtypes.h>
+
+#if defined (HAVE_UNISTD_H)
+#  include <unistd.h>
+#endif
+
+#include <bashansi.h>
+#include <stdio.h>
+
+#include "shell.h"
+
+#define ARENA_BLOCKSIZE	8192
+
+/* Everything handed out is aligned for any of the basic types. */
+#define ARENA_ALIGN(n)	(((n) + sizeof (double) - 1) & ~(sizeof (double) - 1))
+
+typedef struct arena_block {
+  struct arena_block *prev;	/* the block filled before this one */
+  size_t start;			/* arena offset of data[0] */
+  size_t size;			/* bytes available in data */
+  size_t used;			/* bytes handed out */
+  size_t last;			/* offset in data of the latest allocation */
+  double data[1];		/* forces alignment of the storage */
+} ARENA_BLOCK;
+
+#define BLOCK_DATA(b)	((char *)(b)->data)
+
+static ARENA_BLOCK *arena = 0;	/* the block being filled */
+static ARENA_BLOCK *spare = 0;	/* a released block, kept for reuse */
+
+static ARENA_BLOCK *arena_newblock __P((size_t));
+
+static ARENA_BLOCK *
+arena_newblock (n)
+     size_t n;
+{
+  ARENA_BLOCK *b;
+
+  if (n <= ARENA_BLOCKSIZE && spare)
+    {
+      b = spare;
+      spare = 0;
+    }
+  else
+    {
+      if (n < ARENA_BLOCKSIZE)
+	n = ARENA_BLOCKSIZE;
+      b = (ARENA_BLOCK *)xmalloc (sizeof (ARENA_BLOCK) + n);
+      b->size = n;
+    }
+
+  b->prev = arena;
+  b->start = arena ? arena->start + arena->used : 0;
+  b->used = b->last = 0;
+  return b;
+}
+
+/* Return N bytes of storage that lasts until the arena is released to a
+   mark taken before this call. */
+PTR_T
+arena_alloc (n)
+     size_t n;
+{
+  char *r;
+
+  n = ARENA_ALIGN (n ? n : 1);
+  if (arena == 0 || arena->size - arena->used < n)
+    arena = arena_newblock (n);
+
+  r = BLOCK_DATA (arena) + arena->used;
+  arena->last = arena->used;
+  arena->used += n;
+  return ((PTR_T)r);
+}
+
+#if defined (DEBUG)
+/* Return non-zero if P was allocated from the arena and not yet
+   released. */
+static int
+arena_contains (p)
+     const PTR_T p;
+{
+  ARENA_BLOCK *b;
+  const char *s;
+
+  for (s = (const char *)p, b = arena; b; b = b->prev)
+    if (s >= BLOCK_DATA (b) && s < BLOCK_DATA (b) + b->used)
+      return 1;
+  return 0;
+}
+#endif
+
+/* Free P, which came either from malloc or from the latest call to
+   arena_alloc, whose storage is reclaimed at once.  Callers must not pass
+   any other arena storage; telling it from malloc storage would mean
+   searching every block. */
+void
+arena_free (p)
+     PTR_T p;
+{
+  if (p == 0)
+    return;
+  if (arena && (char *)p == BLOCK_DATA (arena) + arena->last)
+    arena->used = arena->last;
+  else
+    {
+#if defined (DEBUG)
+      if (arena_contains (p))
+	{
+	  internal_error ("arena_free: %p: not the latest arena allocation", p);
+	  return;
+	}
+#endif
+      free (p);
+    }
+}
+
+/* Return a mark to pass to arena_release. */
+size_t
+arena_mark ()
+{
+  return (arena ? arena->start + arena->used : 0);
+}
+
+/* Release everything allocated since MARK was taken. */
+void
+arena_release (mark)
+     size_t mark;
+{
+  ARENA_BLOCK *b;
+
+  if (arena == 0 || mark >= arena->start + arena->used)
+    return;
+
+  while (arena->prev && arena->start >= mark)
+    {
+      b = arena;
+      arena = b->prev;
+      if (spare == 0 && b->size == ARENA_BLOCKSIZE)
+	spare = b;
+      else
+	free (b);
+    }
+
+  arena->used = arena->last = (mark > arena->start) ? mark - arena->start : 0;
+}
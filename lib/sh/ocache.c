@@ -0,0 +1,67 @@
+/* ocache.c - keep track of the shell's growable object caches. */
+
+/* Copyright (C) 2011 Free Software Foundation, Inc.
+
+   This file is part of GNU Bash, the Bourne Again SHell.
+
+   Bash is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   Bash is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with Bash.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#include <bashtypes.h>
+
+#if defined (HAVE_UNISTD_H)
+#  include <unistd.h>
+#endif
+
+#include <bashansi.h>
+#include <stdio.h>
+
+#include "shell.h"
+
+/* The caches created with ocache_create_growable, most recent first. */
+static sh_obj_cache_t *ocache_registry = 0;
+
+void
+ocache_register (c)
+     sh_obj_cache_t *c;
+{
+  sh_obj_cache_t *t;
+
+  for (t = ocache_registry; t; t = t->next)
+    if (t == c)
+      return;
+  c->next = ocache_registry;
+  ocache_registry = c;
+}
+
+/* Shrink each registered cache back to the size it was created with.
+   Called when the shell is idle, so a burst of frees (a function with
+   hundreds of local variables returning, say) doesn't leave the objects
+   cached forever. */
+void
+ocache_trim ()
+{
+  sh_obj_cache_t *c;
+
+  for (c = ocache_registry; c; c = c->next)
+    ocache_shrink (*c, c->mincs);
+}
+
+sh_obj_cache_t *
+ocache_list ()
+{
+  return ocache_registry;
+}
@@ -218,7 +218,8 @@ strvec_to_word_list (array, alloc, starting_index)
   for (count = 0; array[count]; count++)
     ;
 
-  for (i = starting_index, list = (WORD_LIST *)NULL; i < count; i++)
+  /* Work from the end of ARRAY so the list is built in order. */
+  for (i = count - 1, list = (WORD_LIST *)NULL; i >= starting_index; i--)
     {
       w = make_bare_word (alloc ? array[i] : "");
       if (alloc == 0)
@@ -228,5 +229,5 @@ strvec_to_word_list (array, alloc, starting_index)
 	}
       list = make_word_list (w, list);
     }
-  return (REVERSE_LIST (list, WORD_LIST *));
+  return (list);
 }
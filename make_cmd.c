@@ -60,10 +60,18 @@ extern int last_command_exit_value;
 /* Object caching */
 sh_obj_cache_t wdcache = {0, 0, 0};
 sh_obj_cache_t wlcache = {0, 0, 0};
+sh_obj_cache_t cmdcache = {0, 0, 0};
+sh_obj_cache_t sccache = {0, 0, 0};
+sh_obj_cache_t conncache = {0, 0, 0};
 
 #define WDCACHESIZE	60
 #define WLCACHESIZE	60
 
+/* Executing a function copies its body, so the caches of command nodes
+   may have to hold a function's worth of them. */
+#define CMDCACHESIZE	32
+#define CMDCACHEMAX	1024
+
 static COMMAND *make_for_or_select __P((enum command_type, WORD_DESC *, WORD_LIST *, COMMAND *, int));
 #if defined (ARITH_FOR_COMMAND)
 static WORD_LIST *make_arith_for_expr __P((char *));
@@ -73,8 +81,11 @@ static COMMAND *make_until_or_while __P((enum command_type, COMMAND *, COMMAND *
 void
 cmd_init ()
 {
-  ocache_create (wdcache, WORD_DESC, WDCACHESIZE);
-  ocache_create (wlcache, WORD_LIST, WLCACHESIZE);
+  ocache_create_growable (wdcache, WORD_DESC, WDCACHESIZE, CMDCACHEMAX, "word");
+  ocache_create_growable (wlcache, WORD_LIST, WLCACHESIZE, CMDCACHEMAX, "wordlist");
+  ocache_create_growable (cmdcache, COMMAND, CMDCACHESIZE, CMDCACHEMAX, "command");
+  ocache_create_growable (sccache, SIMPLE_COM, CMDCACHESIZE, CMDCACHEMAX, "simple");
+  ocache_create_growable (conncache, CONNECTION, CMDCACHESIZE, CMDCACHEMAX, "connection");
 }
 
 WORD_DESC *
@@ -176,6 +187,48 @@ make_word_list (word, wlink)
   return (temp);
 }
 
+void
+wlbuild_init (b)
+     WORD_LIST_BUILDER *b;
+{
+  b->list = b->last = (WORD_LIST *)NULL;
+}
+
+/* Add WORD to the end of the list being built by B.  Returns the new
+   list element. */
+WORD_LIST *
+wlbuild_add (b, word)
+     WORD_LIST_BUILDER *b;
+     WORD_DESC *word;
+{
+  WORD_LIST *temp;
+
+  temp = make_word_list (word, (WORD_LIST *)NULL);
+  if (b->last)
+    b->last->next = temp;
+  else
+    b->list = temp;
+  b->last = temp;
+  return (temp);
+}
+
+/* Add the words in LIST to the end of the list being built by B.  B takes
+   over LIST; the only pass over it is to find its end. */
+void
+wlbuild_append (b, list)
+     WORD_LIST_BUILDER *b;
+     WORD_LIST *list;
+{
+  if (list == 0)
+    return;
+  if (b->last)
+    b->last->next = list;
+  else
+    b->list = list;
+  for (b->last = list; b->last->next; b->last = b->last->next)
+    ;
+}
+
 COMMAND *
 make_command (type, pointer)
      enum command_type type;
@@ -183,7 +236,7 @@ make_command (type, pointer)
 {
   COMMAND *temp;
 
-  temp = (COMMAND *)xmalloc (sizeof (COMMAND));
+  ocache_alloc (cmdcache, COMMAND, temp);
   temp->type = type;
   temp->value.Simple = pointer;
   temp->value.Simple->flags = temp->flags = 0;
@@ -198,7 +251,7 @@ command_connect (com1, com2, connector)
 {
   CONNECTION *temp;
 
-  temp = (CONNECTION *)xmalloc (sizeof (CONNECTION));
+  ocache_alloc (conncache, CONNECTION, temp);
   temp->connector = connector;
   temp->first = com1;
   temp->second = com2;
@@ -369,6 +422,12 @@ make_case_command (word, clauses, lineno)
   temp->line = lineno;
   temp->word = word;
   temp->clauses = REVERSE_LIST (clauses, PATTERN_LIST *);
+  temp->dispatch = (CASE_DISPATCH *)xmalloc (sizeof (CASE_DISPATCH));
+  temp->dispatch->refcount = 1;
+  temp->dispatch->nclauses = -1;
+  temp->dispatch->nnonlit = 0;
+  temp->dispatch->nonlit = (int *)NULL;
+  temp->dispatch->table = (HASH_TABLE *)NULL;
   return (make_command (cm_case, (SIMPLE_COM *)temp));
 }
 
@@ -437,7 +496,7 @@ make_arith_command (exp)
   COMMAND *command;
   ARITH_COM *temp;
 
-  command = (COMMAND *)xmalloc (sizeof (COMMAND));
+  ocache_alloc (cmdcache, COMMAND, command);
   command->value.Arith = temp = (ARITH_COM *)xmalloc (sizeof (ARITH_COM));
 
   temp->flags = 0;
@@ -483,7 +542,7 @@ make_cond_command (cond_node)
 #if defined (COND_COMMAND)
   COMMAND *command;
 
-  command = (COMMAND *)xmalloc (sizeof (COMMAND));
+  ocache_alloc (cmdcache, COMMAND, command);
   command->value.Cond = cond_node;
 
   command->type = cm_cond;
@@ -504,8 +563,9 @@ make_bare_simple_command ()
   COMMAND *command;
   SIMPLE_COM *temp;
 
-  command = (COMMAND *)xmalloc (sizeof (COMMAND));
-  command->value.Simple = temp = (SIMPLE_COM *)xmalloc (sizeof (SIMPLE_COM));
+  ocache_alloc (cmdcache, COMMAND, command);
+  ocache_alloc (sccache, SIMPLE_COM, temp);
+  command->value.Simple = temp;
 
   temp->flags = 0;
   temp->line = line_number;
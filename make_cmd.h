@@ -35,6 +35,19 @@ extern WORD_LIST *make_word_list __P((WORD_DESC *, WORD_LIST *));
 
 #define add_string_to_list(s, l) make_word_list (make_word(s), (l))
 
+/* A WORD_LIST built in order by adding words at its end, so it doesn't
+   have to be reversed when it's complete.  LIST is the finished list. */
+typedef struct word_list_builder {
+  WORD_LIST *list;		/* the first word */
+  WORD_LIST *last;		/* the last word */
+} WORD_LIST_BUILDER;
+
+extern void wlbuild_init __P((WORD_LIST_BUILDER *));
+extern WORD_LIST *wlbuild_add __P((WORD_LIST_BUILDER *, WORD_DESC *));
+extern void wlbuild_append __P((WORD_LIST_BUILDER *, WORD_LIST *));
+
+#define wlbuild_add_string(b, s)	wlbuild_add ((b), make_word (s))
+
 extern COMMAND *make_command __P((enum command_type, SIMPLE_COM *));
 extern COMMAND *command_connect __P((COMMAND *, COMMAND *, int));
 extern COMMAND *make_for_command __P((WORD_DESC *, WORD_LIST *, COMMAND *, int));
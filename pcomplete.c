@@ -282,6 +282,7 @@ filter_stringlist (sl, filterpat, text)
   int i, m, not;
   STRINGLIST *ret;
   char *npat, *t;
+  STRMATCH_PATTERN *cpat;
 
   if (sl == 0 || sl->list == 0 || sl->list_len == 0)
     return sl;
@@ -290,11 +291,12 @@ filter_stringlist (sl, filterpat, text)
 
   not = (npat[0] == '!');
   t = not ? npat + 1 : npat;
+  cpat = strmatch_compile (t, FNMATCH_EXTFLAG);
 
   ret = strlist_create (sl->list_size);
   for (i = 0; i < sl->list_len; i++)
     {
-      m = strmatch (t, sl->list[i], FNMATCH_EXTFLAG);
+      m = strmatch_compiled (cpat, sl->list[i]);
       if ((not && m == FNM_NOMATCH) || (not == 0 && m != FNM_NOMATCH))
 	free (sl->list[i]);
       else
@@ -302,6 +304,7 @@ filter_stringlist (sl, filterpat, text)
     }
 
   ret->list[ret->list_len] = (char *)NULL;
+  strmatch_dispose (cpat);
   if (npat != filterpat)
     free (npat);
 
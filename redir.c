@@ -52,6 +52,7 @@ extern int errno;
 #include "flags.h"
 #include "execute_cmd.h"
 #include "redir.h"
+#include "hashcmd.h"
 
 #if defined (BUFFERED_INPUT)
 #  include "input.h"
@@ -642,6 +643,10 @@ redir_open (filename, flags, mode, ri)
 #endif /* AFS */
     }
 
+  /* A new file might be a command the negative cache says isn't there. */
+  if (fd >= 0 && (flags & O_CREAT))
+    phash_miss_expire ();
+
   return fd;
 }
 
@@ -380,6 +380,7 @@ main (argc, argv, env)
     exit (2);
 
   xtrace_init ();
+  uwp_init ();
 
 #if defined (USING_BASH_MALLOC) && defined (DEBUG) && !defined (DISABLE_MALLOC_WRAPPERS)
 #  if 1
@@ -1379,15 +1380,10 @@ open_shell_script (script_name)
      char *script_name;
 {
   int fd, e, fd_is_tty;
-  char *filename, *path_filename, *t;
+  char *filename, *path_filename;
   char sample[80];
   int sample_len;
   struct stat sb;
-#if defined (ARRAY_VARS)
-  SHELL_VAR *funcname_v, *bash_source_v, *bash_lineno_v;
-  ARRAY *funcname_a, *bash_source_a, *bash_lineno_a;
-#endif
-
   filename = savestring (script_name);
 
   fd = open (filename, O_RDONLY);
@@ -1423,18 +1419,7 @@ open_shell_script (script_name)
     }
 
 #if defined (ARRAY_VARS)
-  GET_ARRAY_FROM_VAR ("FUNCNAME", funcname_v, funcname_a);
-  GET_ARRAY_FROM_VAR ("BASH_SOURCE", bash_source_v, bash_source_a);
-  GET_ARRAY_FROM_VAR ("BASH_LINENO", bash_lineno_v, bash_lineno_a);
-
-  array_push (bash_source_a, filename);
-  if (bash_lineno_a)
-    {
-      t = itos (executing_line_number ());
-      array_push (bash_lineno_a, t);
-      free (t);
-    }
-  array_push (funcname_a, "main");
+  push_call_frame ("main", filename, executing_line_number ());
 #endif
 
 #ifdef HAVE_DEV_FD
@@ -1773,6 +1758,9 @@ shell_reinitialize ()
      the environment is parsed. */
   delete_all_contexts (shell_variables);
   delete_all_variables (shell_functions);
+#if defined (ARRAY_VARS)
+  clear_call_stack ();
+#endif
 
   reinit_special_variables ();
 
@@ -216,6 +216,7 @@ static WORD_LIST *expand_string_for_rhs __P((char *, int, int *, int *));
 
 static WORD_LIST *list_quote_escapes __P((WORD_LIST *));
 static char *make_quoted_char __P((int));
+static char *quote_string_internal __P((char *, int));
 static WORD_LIST *quote_list __P((WORD_LIST *));
 
 static int unquoted_substring __P((char *, char *));
@@ -226,6 +227,7 @@ static SHELL_VAR *do_compound_assignment __P((char *, char *, int));
 #endif
 static int do_assignment_internal __P((const WORD_DESC *, int));
 
+static int skip_field_bytes __P((const char *, int, size_t, int, int, int));
 static char *string_extract_verbatim __P((char *, size_t, int *, char *, int));
 static char *string_extract __P((char *, int *, char *, int));
 static char *string_extract_double_quoted __P((char *, int *, int));
@@ -240,6 +242,7 @@ static char *pos_params __P((char *, int, int, int));
 
 static unsigned char *mb_getcharlens __P((char *, int));
 
+static STRMATCH_PATTERN *umatch_compile __P((char *, char *));
 static char *remove_upattern __P((char *, char *, int));
 #if defined (HANDLE_MULTIBYTE) 
 static wchar_t *remove_wpattern __P((wchar_t *, size_t, wchar_t *, int));
@@ -312,6 +315,9 @@ static WORD_LIST *brace_expand_word_list __P((WORD_LIST *, int));
 #endif
 #if defined (ARRAY_VARS)
 static int make_internal_declare __P((char *, char *));
+static int quoted_array_reference __P((WORD_DESC *));
+static WORD_DESC *array_element_word __P((char *, int));
+static WORD_LIST *expand_quoted_array_word __P((WORD_DESC *, int));
 #endif
 static WORD_LIST *shell_expand_word_list __P((WORD_LIST *, int));
 static WORD_LIST *expand_word_list_internal __P((WORD_LIST *, int));
@@ -645,7 +651,8 @@ unquoted_substring (substr, string)
 
 /* Append SOURCE to TARGET at INDEX.  SIZE is the current amount
    of space allocated to TARGET.  SOURCE can be NULL, in which
-   case nothing happens.  Gets rid of SOURCE by freeing it.
+   case nothing happens.  Gets rid of SOURCE by freeing it; it may also be
+   the latest allocation from the expansion arena.
    Returns TARGET in case the location has changed. */
 INLINE char *
 sub_append_string (source, target, indx, size)
@@ -668,7 +675,7 @@ sub_append_string (source, target, indx, size)
       *indx += srclen;
       target[*indx] = '\0';
 
-      free (source);
+      arena_free (source);
     }
   return (target);
 }
@@ -1034,8 +1041,49 @@ skip_single_quoted (string, slen, sind)
   return c;
 }
 
+/* Most of the bytes in a field need no attention when splitting on $IFS.
+   skip_field_bytes checks a machine word's worth of them at once against
+   the bytes that might end the field, using the usual trick for finding a
+   zero byte in a word. */
+typedef unsigned long fieldchunk_t;
+
+#define FC_ONES		((fieldchunk_t)-1 / UCHAR_MAX)
+#define FC_HIGHS	(FC_ONES * 0x80)
+
+/* Non-zero if some byte of V is less than N, which is at most 0x80. */
+#define FC_HASLESS(v, n)	(((v) - FC_ONES * (n)) & ~(v) & FC_HIGHS)
+
+/* Return the index of the first byte at or after I in STRING, which is
+   SLEN bytes long, that is less than LESS, is SEP, or, if MB is non-zero,
+   is not ASCII and so might start a multibyte character.  LESS is at
+   least 2, so the scan always stops at CTLESC and the terminating NUL. */
+static int
+skip_field_bytes (string, i, slen, less, sep, mb)
+     const char *string;
+     int i;
+     size_t slen;
+     int less, sep, mb;
+{
+  const unsigned char *s;
+  fieldchunk_t v, vsep;
+
+  vsep = FC_ONES * (unsigned char)sep;
+  for ( ; i + sizeof (fieldchunk_t) <= slen; i += sizeof (fieldchunk_t))
+    {
+      memcpy (&v, string + i, sizeof (fieldchunk_t));
+      if (FC_HASLESS (v, less) || FC_HASLESS (v ^ vsep, 1) || (mb && (v & FC_HIGHS)))
+	break;
+    }
+
+  for (s = (const unsigned char *)string + i; *s >= less && *s != sep; s++)
+    if (mb && *s >= 0x80)
+      break;
+  return (s - (const unsigned char *)string);
+}
+
 /* Just like string_extract, but doesn't hack backslashes or any of
-   that other stuff.  Obeys CTLESC quoting.  Used to do splitting on $IFS. */
+   that other stuff.  Obeys CTLESC quoting.  Used to do splitting on $IFS.
+   SLEN is the length of STRING. */
 static char *
 string_extract_verbatim (string, slen, sindex, charlist, flags)
      char *string;
@@ -1049,8 +1097,8 @@ string_extract_verbatim (string, slen, sindex, charlist, flags)
   size_t clen;
   wchar_t *wcharlist;
 #endif
-  int c;
-  char *temp;
+  int c, less, sep;
+  char *temp, *t;
   DECLARE_MBSTATE;
 
   if (charlist[0] == '\'' && charlist[1] == '\0')
@@ -1070,11 +1118,41 @@ string_extract_verbatim (string, slen, sindex, charlist, flags)
   clen = strlen (charlist);
   wcharlist = 0;
 #endif
-  while (c = string[i])
+
+  /* Runs of ordinary characters may be skipped with skip_field_bytes if
+     CHARLIST is a single ASCII character, or holds at most one ASCII
+     character that is not white space or a control character.  In the
+     second case the rest are below `!', so anything below `!' stops the
+     scan and is looked at below. */
+  less = 2;
+  sep = 0;
+  if (charlist[0] && charlist[1] == '\0')
+    {
+      sep = charlist[0];
+      if ((unsigned char)sep >= 0x80)
+	less = 0;
+    }
+  else
+    for (t = charlist; less && *t; t++)
+      {
+	if ((unsigned char)*t < '!')
+	  less = '!';
+	else if (sep == 0 && (unsigned char)*t < 0x80)
+	  sep = *t;
+	else
+	  less = 0;
+      }
+
+  while (1)
     {
 #if defined (HANDLE_MULTIBYTE)
       size_t mblength;
 #endif
+      if (less)
+	i = skip_field_bytes (string, i, slen, less, sep, MB_CUR_MAX > 1);
+      if ((c = string[i]) == 0)
+	break;
+
       if ((flags & SX_NOCTLESC) == 0 && c == CTLESC)
 	{
 	  i += 2;
@@ -2401,7 +2479,8 @@ list_string (string, separators, quoted)
      register char *string, *separators;
      int quoted;
 {
-  WORD_LIST *result;
+  WORD_LIST_BUILDER result;
+  WORD_LIST *w;
   WORD_DESC *t;
   char *current_word, *s;
   int sindex, sh_style_split, whitesep, xflags;
@@ -2439,11 +2518,10 @@ list_string (string, separators, quoted)
 	extract a word, stopping at a separator
 	skip sequences of spc, tab, or nl as long as they are separators
      This obeys the field splitting rules in Posix.2. */
-  slen = (MB_CUR_MAX > 1) ? strlen (string) : 1;
-  for (result = (WORD_LIST *)NULL, sindex = 0; string[sindex]; )
+  slen = strlen (string);
+  wlbuild_init (&result);
+  for (sindex = 0; string[sindex]; )
     {
-      /* Don't need string length in ADVANCE_CHAR or string_extract_verbatim
-	 unless multibyte chars are possible. */
       current_word = string_extract_verbatim (string, slen, &sindex, separators, xflags);
       if (current_word == 0)
 	break;
@@ -2457,17 +2535,17 @@ list_string (string, separators, quoted)
 	  t = alloc_word_desc ();
 	  t->word = make_quoted_char ('\0');
 	  t->flags |= W_QUOTED|W_HASQUOTEDNULL;
-	  result = make_word_list (t, result);
+	  wlbuild_add (&result, t);
 	}
       else if (current_word[0] != '\0')
 	{
 	  /* If we have something, then add it regardless.  However,
 	     perform quoted null character removal on the current word. */
 	  remove_quoted_nulls (current_word);
-	  result = add_string_to_list (current_word, result);
-	  result->word->flags &= ~W_HASQUOTEDNULL;	/* just to be sure */
+	  w = wlbuild_add_string (&result, current_word);
+	  w->word->flags &= ~W_HASQUOTEDNULL;	/* just to be sure */
 	  if (quoted & (Q_DOUBLE_QUOTES|Q_HERE_DOCUMENT))
-	    result->word->flags |= W_QUOTED;
+	    w->word->flags |= W_QUOTED;
 	}
 
       /* If we're not doing sequences of separators in the traditional
@@ -2477,7 +2555,7 @@ list_string (string, separators, quoted)
 	  t = alloc_word_desc ();
 	  t->word = make_quoted_char ('\0');
 	  t->flags |= W_QUOTED|W_HASQUOTEDNULL;
-	  result = make_word_list (t, result);
+	  wlbuild_add (&result, t);
 	}
 
       free (current_word);
@@ -2510,7 +2588,7 @@ list_string (string, separators, quoted)
 	    sindex++;
 	}
     }
-  return (REVERSE_LIST (result, WORD_LIST *));
+  return (result.list);
 }
 
 /* Parse a single word from STRING, using SEPARATORS to separate fields.
@@ -2568,9 +2646,7 @@ get_word_from_string (stringp, separators, endptr)
 
      This obeys the field splitting rules in Posix.2. */
   sindex = 0;
-  /* Don't need string length in ADVANCE_CHAR or string_extract_verbatim
-     unless multibyte chars are possible. */
-  slen = (MB_CUR_MAX > 1) ? strlen (s) : 1;
+  slen = strlen (s);
   current_word = string_extract_verbatim (s, slen, &sindex, separators, xflags);
 
   /* Set ENDPTR to the first character after the end of the word. */
@@ -2891,17 +2967,20 @@ do_assignment_no_expand (string)
 WORD_LIST *
 list_rest_of_args ()
 {
-  register WORD_LIST *list, *args;
+  WORD_LIST_BUILDER list;
+  register WORD_LIST *args;
   int i;
 
+  wlbuild_init (&list);
+
   /* Break out of the loop as soon as one of the dollar variables is null. */
-  for (i = 1, list = (WORD_LIST *)NULL; i < 10 && dollar_vars[i]; i++)
-    list = make_word_list (make_bare_word (dollar_vars[i]), list);
+  for (i = 1; i < 10 && dollar_vars[i]; i++)
+    wlbuild_add (&list, make_bare_word (dollar_vars[i]));
 
   for (args = rest_of_args; args; args = args->next)
-    list = make_word_list (make_bare_word (args->word->word), list);
+    wlbuild_add (&list, make_bare_word (args->word->word));
 
-  return (REVERSE_LIST (list, WORD_LIST *));
+  return (list.list);
 }
 
 int
@@ -3550,14 +3629,27 @@ make_quoted_char (c)
 char *
 quote_string (string)
      char *string;
+{
+  return (quote_string_internal (string, 0));
+}
+
+/* Quote STRING as quote_string does.  If USE_ARENA is non-zero, the result
+   is allocated from the expansion arena and lasts only until the current
+   command completes. */
+static char *
+quote_string_internal (string, use_arena)
+     char *string;
+     int use_arena;
 {
   register char *t;
   size_t slen;
   char *result, *send;
 
+  slen = (*string == 0) ? 2 : (strlen (string) * 2) + 1;
+  result = use_arena ? (char *)arena_alloc (slen) : (char *)xmalloc (slen);
+
   if (*string == 0)
     {
-      result = (char *)xmalloc (2);
       result[0] = CTLNUL;
       result[1] = '\0';
     }
@@ -3565,10 +3657,7 @@ quote_string (string)
     {
       DECLARE_MBSTATE;
 
-      slen = strlen (string);
-      send = string + slen;
-
-      result = (char *)xmalloc ((slen * 2) + 1);
+      send = string + (slen / 2);
 
       for (t = result; string < send; )
 	{
@@ -3652,6 +3741,8 @@ dequote_list (list)
 
   for (tlist = list; tlist; tlist = tlist->next)
     {
+      if (tlist->word->flags & W_DEQUOTED)
+	continue;
       s = dequote_string (tlist->word->word);
       if (QUOTED_NULL (tlist->word->word))
 	tlist->word->flags &= ~W_HASQUOTEDNULL;
@@ -3791,6 +3882,42 @@ mb_getcharlens (string, len)
 #define RP_LONG_RIGHT	3
 #define RP_SHORT_RIGHT	4
 
+/* The last pattern compiled by umatch_compile.  Pattern substitution calls
+   match_upattern once for each replacement with the same pattern, and
+   loops tend to use the same pattern over and over. */
+static char *umatch_lastpat;
+static int umatch_lastflags;
+static STRMATCH_PATTERN *umatch_lastcpat;
+
+/* Return PAT compiled for matching against STRING and its substrings.  The
+   result belongs to umatch_compile; callers don't free it. */
+static STRMATCH_PATTERN *
+umatch_compile (pat, string)
+     char *pat, *string;
+{
+  int flags;
+
+  flags = FNMATCH_EXTFLAG;
+#if defined (HANDLE_MULTIBYTE)
+  /* If STRING has no multibyte characters, neither do its substrings. */
+  if (MB_CUR_MAX == 1 || mbsmbchar (string) == 0)
+#endif
+    flags |= FNM_SBSTRING;
+
+  if (umatch_lastcpat && flags == umatch_lastflags && STREQ (pat, umatch_lastpat))
+    return (umatch_lastcpat);
+
+  if (umatch_lastcpat)
+    {
+      strmatch_dispose (umatch_lastcpat);
+      free (umatch_lastpat);
+    }
+  umatch_lastpat = savestring (pat);
+  umatch_lastflags = flags;
+  umatch_lastcpat = strmatch_compile (umatch_lastpat, flags);
+  return (umatch_lastcpat);
+}
+
 /* Returns its first argument if nothing matched; new memory otherwise */
 static char *
 remove_upattern (param, pattern, op)
@@ -3800,17 +3927,22 @@ remove_upattern (param, pattern, op)
   register int len;
   register char *end;
   register char *p, *ret, c;
+  STRMATCH_PATTERN *cpat;
 
   len = STRLEN (param);
   end = param + len;
 
+  /* We try the pattern against up to LEN+1 substrings of PARAM, so we
+     analyze it only once. */
+  cpat = umatch_compile (pattern, param);
+
   switch (op)
     {
       case RP_LONG_LEFT:	/* remove longest match at start */
 	for (p = end; p >= param; p--)
 	  {
 	    c = *p; *p = '\0';
-	    if (strmatch (pattern, param, FNMATCH_EXTFLAG) != FNM_NOMATCH)
+	    if (strmatch_compiled (cpat, param) != FNM_NOMATCH)
 	      {
 		*p = c;
 		return (savestring (p));
@@ -3824,7 +3956,7 @@ remove_upattern (param, pattern, op)
 	for (p = param; p <= end; p++)
 	  {
 	    c = *p; *p = '\0';
-	    if (strmatch (pattern, param, FNMATCH_EXTFLAG) != FNM_NOMATCH)
+	    if (strmatch_compiled (cpat, param) != FNM_NOMATCH)
 	      {
 		*p = c;
 		return (savestring (p));
@@ -3836,7 +3968,7 @@ remove_upattern (param, pattern, op)
       case RP_LONG_RIGHT:	/* remove longest match at end */
 	for (p = param; p <= end; p++)
 	  {
-	    if (strmatch (pattern, p, FNMATCH_EXTFLAG) != FNM_NOMATCH)
+	    if (strmatch_compiled (cpat, p) != FNM_NOMATCH)
 	      {
 		c = *p; *p = '\0';
 		ret = savestring (param);
@@ -3849,7 +3981,7 @@ remove_upattern (param, pattern, op)
       case RP_SHORT_RIGHT:	/* remove shortest match at end */
 	for (p = end; p >= param; p--)
 	  {
-	    if (strmatch (pattern, p, FNMATCH_EXTFLAG) != FNM_NOMATCH)
+	    if (strmatch_compiled (cpat, p) != FNM_NOMATCH)
 	      {
 		c = *p; *p = '\0';
 		ret = savestring (param);
@@ -4011,7 +4143,8 @@ match_upattern (string, pat, mtype, sp, ep)
   int c, len, mlen;
   register char *p, *p1, *npat;
   char *end;
-  int n1;
+  int n1, r;
+  STRMATCH_PATTERN *cpat;
 
   /* If the pattern doesn't match anywhere in the string, go ahead and
      short-circuit right away.  A minor optimization, saves a bunch of
@@ -4047,6 +4180,10 @@ match_upattern (string, pat, mtype, sp, ep)
 
   mlen = umatchlen (pat, len);
 
+  /* The loops below match PAT against many substrings of STRING. */
+  cpat = umatch_compile (pat, string);
+  r = 0;
+
   switch (mtype)
     {
     case MATCH_ANY:
@@ -4072,12 +4209,13 @@ match_upattern (string, pat, mtype, sp, ep)
 #endif
 		{
 		  c = *p1; *p1 = '\0';
-		  if (strmatch (pat, p, FNMATCH_EXTFLAG) == 0)
+		  if (strmatch_compiled (cpat, p) == 0)
 		    {
 		      *p1 = c;
 		      *sp = p;
 		      *ep = p1;
-		      return 1;
+		      r = 1;
+		      goto done;
 		    }
 		  *p1 = c;
 #if 1
@@ -4088,12 +4226,11 @@ match_upattern (string, pat, mtype, sp, ep)
 		}
 	    }
 	}
-
-      return (0);
+      break;
 
     case MATCH_BEG:
       if (match_pattern_char (pat, string) == 0)
-	return (0);
+	break;
 
 #if 0
       for (p = end; p >= string; p--)
@@ -4102,12 +4239,13 @@ match_upattern (string, pat, mtype, sp, ep)
 #endif
 	{
 	  c = *p; *p = '\0';
-	  if (strmatch (pat, string, FNMATCH_EXTFLAG) == 0)
+	  if (strmatch_compiled (cpat, string) == 0)
 	    {
 	      *p = c;
 	      *sp = string;
 	      *ep = p;
-	      return 1;
+	      r = 1;
+	      break;
 	    }
 	  *p = c;
 #if 1
@@ -4116,8 +4254,7 @@ match_upattern (string, pat, mtype, sp, ep)
 	    break;
 #endif
 	}
-
-      return (0);
+      break;
 
     case MATCH_END:
 #if 0
@@ -4126,11 +4263,12 @@ match_upattern (string, pat, mtype, sp, ep)
       for (p = end - ((mlen == -1) ? len : mlen); p <= end; p++)
 #endif
 	{
-	  if (strmatch (pat, p, FNMATCH_EXTFLAG) == 0)
+	  if (strmatch_compiled (cpat, p) == 0)
 	    {
 	      *sp = p;
 	      *ep = end;
-	      return 1;
+	      r = 1;
+	      break;
 	    }
 #if 1
 	  /* If MLEN != -1, we have a fixed length pattern. */
@@ -4138,11 +4276,11 @@ match_upattern (string, pat, mtype, sp, ep)
 	    break;
 #endif
 	}
-
-      return (0);
+      break;
     }
 
-  return (0);
+done:
+  return (r);
 }
 
 #if defined (HANDLE_MULTIBYTE)
@@ -4432,19 +4570,21 @@ list_remove_pattern (list, pattern, patspec, itype, quoted)
      char *pattern;
      int patspec, itype, quoted;
 {
-  WORD_LIST *new, *l;
+  WORD_LIST_BUILDER new;
+  WORD_LIST *l;
   WORD_DESC *w;
   char *tword;
 
-  for (new = (WORD_LIST *)NULL, l = list; l; l = l->next)
+  wlbuild_init (&new);
+  for (l = list; l; l = l->next)
     {
       tword = remove_pattern (l->word->word, pattern, patspec);
       w = alloc_word_desc ();
       w->word = tword ? tword : savestring ("");
-      new = make_word_list (w, new);
+      wlbuild_add (&new, w);
     }
 
-  l = REVERSE_LIST (new, WORD_LIST *);
+  l = new.list;
   tword = string_list_pos_params (itype, l, quoted);
   dispose_words (l);
 
@@ -4478,7 +4618,7 @@ array_remove_pattern (var, pattern, patspec, varname, quoted)
      int quoted;
 {
   ARRAY *a;
-  HASH_TABLE *h;
+  ASSOC_TABLE *h;
   int itype;
   char *ret;
   WORD_LIST *list;
@@ -5486,7 +5626,7 @@ array_length_reference (s)
   char *akey;
   char *t, c;
   ARRAY *array;
-  HASH_TABLE *h;
+  ASSOC_TABLE *h;
   SHELL_VAR *var;
 
   var = array_variable_part (s, &t, &len);
@@ -5510,7 +5650,7 @@ array_length_reference (s)
      v[*].  Return 0 for everything else. */
 
   array = array_p (var) ? array_cell (var) : (ARRAY *)NULL;
-  h = assoc_p (var) ? assoc_cell (var) : (HASH_TABLE *)NULL;
+  h = assoc_p (var) ? assoc_cell (var) : (ASSOC_TABLE *)NULL;
 
   if (ALL_ELEMENT_SUB (t[0]) && t[1] == ']')
     {
@@ -6072,7 +6212,7 @@ verify_substring_values (v, value, substr, vtype, e1p, e2p)
   int expok;
 #if defined (ARRAY_VARS)
  ARRAY *a;
- HASH_TABLE *h;
+ ASSOC_TABLE *h;
 #endif
 
   /* duplicate behavior of strchr(3) */
@@ -8397,7 +8537,7 @@ add_twochars:
 	  if (temp)
 	    {
 	      temp1 = temp;
-	      temp = quote_string (temp);
+	      temp = quote_string_internal (temp, 1);
 	      free (temp1);
 	      goto add_string;
 	    }
@@ -8815,21 +8955,13 @@ static WORD_LIST *
 word_list_split (list)
      WORD_LIST *list;
 {
-  WORD_LIST *result, *t, *tresult, *e;
+  WORD_LIST_BUILDER result;
+  WORD_LIST *t;
 
-  for (t = list, result = (WORD_LIST *)NULL; t; t = t->next)
-    {
-      tresult = word_split (t->word, ifs_value);
-      if (result == 0)
-        result = e = tresult;
-      else
-	{
-	  e->next = tresult;
-	  while (e->next)
-	    e = e->next;
-	}
-    }
-  return (result);
+  wlbuild_init (&result);
+  for (t = list; t; t = t->next)
+    wlbuild_append (&result, word_split (t->word, ifs_value));
+  return (result.list);
 }
 
 /**************************************************
@@ -8959,6 +9091,7 @@ separate_out_assignments (tlist)
 #define WEXP_TILDEEXP	0x004
 #define WEXP_PARAMEXP	0x008
 #define WEXP_PATHEXP	0x010
+#define WEXP_BORROW	0x020	/* "${name[@]}" may share the array's strings */
 
 /* All of the expansions, including variable assignments at the start of
    the list. */
@@ -8986,6 +9119,16 @@ expand_words (list)
 
 /* Same as expand_words (), but doesn't hack variable or environment
    variables. */
+/* Same as expand_words (), but the words that "${name[@]}" expands into
+   may share the strings of the array NAME rather than copying them.  The
+   caller has to make sure no array is changed while the list is in use. */
+WORD_LIST *
+expand_words_borrow (list)
+     WORD_LIST *list;
+{
+  return (expand_word_list_internal (list, WEXP_ALL|WEXP_BORROW));
+}
+
 WORD_LIST *
 expand_words_no_vars (list)
      WORD_LIST *list;
@@ -9007,10 +9150,12 @@ glob_expand_word_list (tlist, eflags)
 {
   char **glob_array, *temp_string;
   register int glob_index;
-  WORD_LIST *glob_list, *output_list, *disposables, *next;
+  WORD_LIST_BUILDER output_list;
+  WORD_LIST *disposables, *next;
   WORD_DESC *tword;
 
-  output_list = disposables = (WORD_LIST *)NULL;
+  wlbuild_init (&output_list);
+  disposables = (WORD_LIST *)NULL;
   glob_array = (char **)NULL;
   while (tlist)
     {
@@ -9021,15 +9166,16 @@ glob_expand_word_list (tlist, eflags)
 	 expansions are left unchanged (the shell default), the
 	 original word is added to orig_list.  If globbing fails and
 	 failed glob expansions are removed, the original word is
-	 added to the list of disposable words.  orig_list ends up
-	 in reverse order and requires a call to REVERSE_LIST to
-	 be set right.  After all words are examined, the disposable
-	 words are freed. */
+	 added to the list of disposable words.  After all words are
+	 examined, the disposable words are freed. */
       next = tlist->next;
+      tlist->next = (WORD_LIST *)NULL;
 
       /* If the word isn't an assignment and contains an unquoted
 	 pattern matching character, then glob it. */
-      if ((tlist->word->flags & W_NOGLOB) == 0 &&
+      if (tlist->word->flags & W_DEQUOTED)
+	wlbuild_append (&output_list, tlist);
+      else if ((tlist->word->flags & W_NOGLOB) == 0 &&
 	  unquoted_glob_pattern_p (tlist->word->word))
 	{
 	  glob_array = shell_glob_filename (tlist->word->word);
@@ -9053,20 +9199,16 @@ glob_expand_word_list (tlist, eflags)
 	      tlist->word->word = temp_string;
 	    }
 
-	  /* Make the array into a word list. */
-	  glob_list = (WORD_LIST *)NULL;
+	  /* Add the matches to the output list. */
 	  for (glob_index = 0; glob_array[glob_index]; glob_index++)
 	    {
 	      tword = make_bare_word (glob_array[glob_index]);
 	      tword->flags |= W_GLOBEXP;	/* XXX */
-	      glob_list = make_word_list (tword, glob_list);
+	      wlbuild_add (&output_list, tword);
 	    }
 
-	  if (glob_list)
-	    {
-	      output_list = (WORD_LIST *)list_append (glob_list, output_list);
-	      PREPEND_LIST (tlist, disposables);
-	    }
+	  if (glob_index > 0)
+	    PREPEND_LIST (tlist, disposables);
 	  else if (fail_glob_expansion != 0)
 	    {
 	      report_error (_("no match: %s"), tlist->word->word);
@@ -9075,7 +9217,7 @@ glob_expand_word_list (tlist, eflags)
 	  else if (allow_null_glob_expansion == 0)
 	    {
 	      /* Failed glob expressions are left unchanged. */
-	      PREPEND_LIST (tlist, output_list);
+	      wlbuild_append (&output_list, tlist);
 	    }
 	  else
 	    {
@@ -9089,7 +9231,7 @@ glob_expand_word_list (tlist, eflags)
 	  temp_string = dequote_string (tlist->word->word);
 	  free (tlist->word->word);
 	  tlist->word->word = temp_string;
-	  PREPEND_LIST (tlist, output_list);
+	  wlbuild_append (&output_list, tlist);
 	}
 
       strvec_dispose (glob_array);
@@ -9101,10 +9243,7 @@ glob_expand_word_list (tlist, eflags)
   if (disposables)
     dispose_words (disposables);
 
-  if (output_list)
-    output_list = REVERSE_LIST (output_list, WORD_LIST *);
-
-  return (output_list);
+  return (output_list.list);
 }
 
 #if defined (BRACE_EXPANSION)
@@ -9115,28 +9254,29 @@ brace_expand_word_list (tlist, eflags)
 {
   register char **expansions;
   char *temp_string;
-  WORD_LIST *disposables, *output_list, *next;
+  WORD_LIST_BUILDER output_list;
+  WORD_LIST *disposables, *next;
   WORD_DESC *w;
   int eindex;
 
-  for (disposables = output_list = (WORD_LIST *)NULL; tlist; tlist = next)
+  wlbuild_init (&output_list);
+  for (disposables = (WORD_LIST *)NULL; tlist; tlist = next)
     {
       next = tlist->next;
+      tlist->next = (WORD_LIST *)NULL;
 
       if ((tlist->word->flags & (W_COMPASSIGN|W_ASSIGNARG)) == (W_COMPASSIGN|W_ASSIGNARG))
         {
 /*itrace("brace_expand_word_list: %s: W_COMPASSIGN|W_ASSIGNARG", tlist->word->word);*/
-	  PREPEND_LIST (tlist, output_list);
+	  wlbuild_append (&output_list, tlist);
 	  continue;
         }
           
       /* Only do brace expansion if the word has a brace character.  If
-	 not, just add the word list element to BRACES and continue.  In
-	 the common case, at least when running shell scripts, this will
-	 degenerate to a bunch of calls to `mbschr', and then what is
-	 basically a reversal of TLIST into BRACES, which is corrected
-	 by a call to REVERSE_LIST () on BRACES when the end of TLIST
-	 is reached. */
+	 not, just add the word list element to the output list and
+	 continue.  In the common case, at least when running shell
+	 scripts, this will degenerate to a bunch of calls to `mbschr'
+	 that relink TLIST into the output list unchanged. */
       if (mbschr (tlist->word->word, LBRACE))
 	{
 	  expansions = brace_expand (tlist->word->word);
@@ -9149,7 +9289,7 @@ brace_expand_word_list (tlist, eflags)
 		 unconditionally someday -- XXX */
 	      if (STREQ (temp_string, tlist->word->word))
 		w->flags = tlist->word->flags;
-	      output_list = make_word_list (w, output_list);
+	      wlbuild_add (&output_list, w);
 	      free (expansions[eindex]);
 	    }
 	  free (expansions);
@@ -9159,16 +9299,13 @@ brace_expand_word_list (tlist, eflags)
 	  PREPEND_LIST (tlist, disposables);
 	}
       else
-	PREPEND_LIST (tlist, output_list);
+	wlbuild_append (&output_list, tlist);
     }
 
   if (disposables)
     dispose_words (disposables);
 
-  if (output_list)
-    output_list = REVERSE_LIST (output_list, WORD_LIST *);
-
-  return (output_list);
+  return (output_list.list);
 }
 #endif
 
@@ -9194,6 +9331,114 @@ make_internal_declare (word, option)
 
   return (declare_builtin (wl));  
 }  
+
+/* If WORD is exactly "${NAME[@]}", return the length of NAME, which
+   starts three characters into WORD's string.  Otherwise return 0. */
+static int
+quoted_array_reference (word)
+     WORD_DESC *word;
+{
+  char *s;
+  int i;
+
+  s = word->word;
+  if ((word->flags & ~(W_HASDOLLAR|W_QUOTED)) || s == 0)
+    return 0;
+  if (s[0] != '"' || s[1] != '$' || s[2] != LBRACE || legal_variable_starter (s[3]) == 0)
+    return 0;
+  for (i = 4; legal_variable_char (s[i]); i++)
+    ;
+  if (s[i] != '[' || s[i+1] != '@' || s[i+2] != ']' || s[i+3] != RBRACE || s[i+4] != '"' || s[i+5])
+    return 0;
+  return (i - 3);
+}
+
+int
+quoted_array_word_p (word)
+     WORD_DESC *word;
+{
+  return (quoted_array_reference (word) > 0);
+}
+
+static WORD_DESC *
+array_element_word (value, flags)
+     char *value;
+     int flags;
+{
+  WORD_DESC *w;
+
+  if (value == 0)
+    value = "";
+  if (flags & W_BORROWED)
+    {
+      w = alloc_word_desc ();
+      w->word = value;
+    }
+  else
+    w = make_bare_word (value);
+  w->flags |= flags;
+  return w;
+}
+
+/* Expand WORD if it's "${NAME[@]}" and NAME is an array with at least one
+   element.  Each element becomes a word directly, rather than being quoted,
+   joined into a single string and split apart again; the words need no
+   quote removal.  If BORROW is non-zero, the words share the element
+   strings of arrays that aren't rebuilt each time they're referenced.
+   Returns NULL if WORD has to be expanded the usual way, which includes
+   the case of $IFS containing the characters the usual way uses to quote
+   the elements; they are split there, and "$@" splits them the same way. */
+static WORD_LIST *
+expand_quoted_array_word (word, borrow)
+     WORD_DESC *word;
+     int borrow;
+{
+  SHELL_VAR *var;
+  ARRAY *a;
+  ARRAY_ELEMENT *ae;
+  ASSOC_TABLE *h;
+  WORD_LIST *list;
+  char *name;
+  int len, c, flags, i;
+
+  if ((len = quoted_array_reference (word)) == 0 || isifs (CTLESC) || isifs (CTLNUL))
+    return ((WORD_LIST *)NULL);
+
+  name = word->word + 3;
+  c = name[len];
+  name[len] = '\0';
+  var = find_variable (name);
+  name[len] = c;
+
+  if (var == 0 || invisible_p (var) || (array_p (var) == 0 && assoc_p (var) == 0))
+    return ((WORD_LIST *)NULL);
+
+  flags = W_QUOTED|W_DEQUOTED;
+  if (borrow && var->dynamic_value == 0)
+    flags |= W_BORROWED;
+
+  /* Work backwards, so the list comes out in order. */
+  list = (WORD_LIST *)NULL;
+  if (assoc_p (var))
+    {
+      h = assoc_cell (var);
+      if (h == 0 || assoc_empty (h))
+	return ((WORD_LIST *)NULL);
+      for (i = h->nused - 1; i >= 0; i--)
+	if (h->entries[i].key)
+	  list = make_word_list (array_element_word (h->entries[i].data, flags), list);
+    }
+  else
+    {
+      a = array_cell (var);
+      if (a == 0 || array_empty (a))
+	return ((WORD_LIST *)NULL);
+      for (ae = element_back (a->head); ae != a->head; ae = element_back (ae))
+	list = make_word_list (array_element_word (element_value (ae), flags), list);
+    }
+
+  return (list);
+}
 #endif
 
 static WORD_LIST *
@@ -9201,12 +9446,13 @@ shell_expand_word_list (tlist, eflags)
      WORD_LIST *tlist;
      int eflags;
 {
-  WORD_LIST *expanded, *orig_list, *new_list, *next, *temp_list;
+  WORD_LIST_BUILDER new_list;
+  WORD_LIST *expanded, *orig_list, *next, *temp_list;
   int expanded_something, has_dollar_at;
   char *temp_string;
 
   /* We do tilde expansion all the time.  This is what 1003.2 says. */
-  new_list = (WORD_LIST *)NULL;
+  wlbuild_init (&new_list);
   for (orig_list = tlist; tlist; tlist = next)
     {
       temp_string = tlist->word->word;
@@ -9239,6 +9485,14 @@ shell_expand_word_list (tlist, eflags)
 	  tlist->word->word[t] = '\0';
 	  tlist->word->flags &= ~(W_ASSIGNMENT|W_NOSPLIT|W_COMPASSIGN|W_ASSIGNARG|W_ASSIGNASSOC);
 	}
+
+      /* "${name[@]}" is common enough as a command argument to be worth
+	 expanding directly. */
+      if (expanded = expand_quoted_array_word (tlist->word, eflags & WEXP_BORROW))
+	{
+	  wlbuild_append (&new_list, expanded);
+	  continue;
+	}
 #endif
 
       expanded_something = 0;
@@ -9254,7 +9508,7 @@ shell_expand_word_list (tlist, eflags)
 	  /* Dispose our copy of the original list. */
 	  dispose_words (orig_list);
 	  /* Dispose the new list we're building. */
-	  dispose_words (new_list);
+	  dispose_words (new_list.list);
 
 	  last_command_exit_value = EXECUTION_FAILURE;
 	  if (expanded == &expand_word_error)
@@ -9279,17 +9533,13 @@ shell_expand_word_list (tlist, eflags)
 	  temp_list = expanded;
 	}
 
-      expanded = REVERSE_LIST (temp_list, WORD_LIST *);
-      new_list = (WORD_LIST *)list_append (expanded, new_list);
+      wlbuild_append (&new_list, temp_list);
     }
 
   if (orig_list)  
     dispose_words (orig_list);
 
-  if (new_list)
-    new_list = REVERSE_LIST (new_list, WORD_LIST *);
-
-  return (new_list);
+  return (new_list.list);
 }
 
 /* The workhorse for expand_words () and expand_words_no_vars ().
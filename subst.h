@@ -242,6 +242,10 @@ extern WORD_LIST *word_split __P((WORD_DESC *, char *));
    variable assignments. */
 extern WORD_LIST *expand_words __P((WORD_LIST *));
 
+/* Same as expand_words (), but the words that "${name[@]}" expands into
+   may share the array's strings. */
+extern WORD_LIST *expand_words_borrow __P((WORD_LIST *));
+
 /* Same as expand_words (), but doesn't hack variable or environment
    variables. */
 extern WORD_LIST *expand_words_no_vars __P((WORD_LIST *));
@@ -251,6 +255,11 @@ extern WORD_LIST *expand_words_no_vars __P((WORD_LIST *));
    command substitution, arithmetic expansion, and word splitting. */
 extern WORD_LIST *expand_words_shellexp __P((WORD_LIST *));
 
+#if defined (ARRAY_VARS)
+/* Return non-zero if WORD is exactly "${name[@]}". */
+extern int quoted_array_word_p __P((WORD_DESC *));
+#endif
+
 extern WORD_DESC *command_substitute __P((char *, int));
 extern char *pat_subst __P((char *, char *, char *, int));
 
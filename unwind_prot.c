@@ -86,10 +86,37 @@ static void clear_unwind_protects_internal __P((char *, char *));
 static inline void restore_variable __P((SAVED_VAR *));
 static void unwind_protect_mem_internal __P((char *, char *));
 
+static PTR_T uwp_alloc __P((int));
+static void uwp_free __P((UNWIND_ELT *));
+
 static UNWIND_ELT *unwind_protect_list = (UNWIND_ELT *)NULL;
 
-#define uwpalloc(elt)	(elt) = (UNWIND_ELT *)xmalloc (sizeof (UNWIND_ELT))
-#define uwpfree(elt)	free(elt)
+/* Unwind-protects are always removed in the reverse of the order in which
+   they were added, so their storage comes from a stack of chunks rather
+   than from malloc.  Each element takes only the space it needs, so a
+   saved variable is stored right after its header, however big it is.
+   The first chunk is allocated once, by uwp_init, and is big enough for
+   a few levels of function calls; deeper recursion adds chunks, and the
+   most recently emptied one is kept for reuse. */
+#define UWP_CHUNKSIZE	4096
+
+/* Everything on the stack is aligned for any of the basic types. */
+#define UWP_ALIGN(n)	(((n) + sizeof (double) - 1) & ~(sizeof (double) - 1))
+
+typedef struct uwp_chunk {
+  struct uwp_chunk *prev;	/* the chunk filled before this one */
+  int size;			/* bytes available in data */
+  int used;			/* bytes in use */
+  double data[1];		/* forces alignment of the storage */
+} UWP_CHUNK;
+
+#define CHUNK_DATA(c)	((char *)(c)->data)
+
+static UWP_CHUNK *uwp_stack = 0;	/* the chunk being filled */
+static UWP_CHUNK *uwp_spare = 0;	/* an emptied chunk, kept for reuse */
+
+#define uwpalloc(elt)	(elt) = (UNWIND_ELT *)uwp_alloc (sizeof (UNWIND_ELT))
+#define uwpfree(elt)	uwp_free (elt)
 
 /* Run a function without interrupts.  This relies on the fact that the
    FUNCTION cannot change the value of interrupt_immediately.  (I.e., does
@@ -183,12 +210,84 @@ have_unwind_protects ()
   return (unwind_protect_list != 0);
 }
 
+/* Allocate the first chunk of the unwind-protect stack. */
+void
+uwp_init ()
+{
+  if (uwp_stack == 0)
+    {
+      uwp_stack = (UWP_CHUNK *)xmalloc (sizeof (UWP_CHUNK) + UWP_CHUNKSIZE);
+      uwp_stack->prev = (UWP_CHUNK *)NULL;
+      uwp_stack->size = UWP_CHUNKSIZE;
+      uwp_stack->used = 0;
+    }
+}
+
 /* **************************************************************** */
 /*								    */
 /*			The Actual Functions		 	    */
 /*								    */
 /* **************************************************************** */
 
+/* Push N bytes onto the unwind-protect stack. */
+static PTR_T
+uwp_alloc (n)
+     int n;
+{
+  UWP_CHUNK *c;
+  char *r;
+
+  if (uwp_stack == 0)
+    uwp_init ();
+
+  n = UWP_ALIGN (n);
+  if (uwp_stack->size - uwp_stack->used < n)
+    {
+      if (uwp_spare && uwp_spare->size >= n)
+	{
+	  c = uwp_spare;
+	  uwp_spare = (UWP_CHUNK *)NULL;
+	}
+      else
+	{
+	  c = (UWP_CHUNK *)xmalloc (sizeof (UWP_CHUNK) + (n > UWP_CHUNKSIZE ? n : UWP_CHUNKSIZE));
+	  c->size = n > UWP_CHUNKSIZE ? n : UWP_CHUNKSIZE;
+	}
+      c->prev = uwp_stack;
+      c->used = 0;
+      uwp_stack = c;
+    }
+
+  r = CHUNK_DATA (uwp_stack) + uwp_stack->used;
+  uwp_stack->used += n;
+  return ((PTR_T)r);
+}
+
+/* Pop ELT, which must be the element most recently pushed and not yet
+   popped, off the unwind-protect stack. */
+static void
+uwp_free (elt)
+     UNWIND_ELT *elt;
+{
+  UWP_CHUNK *c;
+
+  c = uwp_stack;
+  if ((char *)elt < CHUNK_DATA (c) || (char *)elt >= CHUNK_DATA (c) + c->used)
+    {
+      internal_warning ("uwp_free: %p: not the top of the unwind-protect stack", elt);
+      return;
+    }
+
+  c->used = (char *)elt - CHUNK_DATA (c);
+  if (c->used == 0 && c->prev)
+    {
+      uwp_stack = c->prev;
+      if (uwp_spare)
+	free (uwp_spare);
+      uwp_spare = c;
+    }
+}
+
 static void
 add_unwind_protect_internal (cleanup, arg)
      Function *cleanup;
@@ -228,12 +327,24 @@ static void
 clear_unwind_protects_internal (flag, ignore)
      char *flag, *ignore;
 {
+  UWP_CHUNK *c;
+
   if (flag)
     {
       while (unwind_protect_list)
 	remove_unwind_protect_internal ((char *)NULL, (char *)NULL);
     }
   unwind_protect_list = (UNWIND_ELT *)NULL;
+
+  /* Forgetting the elements empties the stack. */
+  while (uwp_stack && uwp_stack->prev)
+    {
+      c = uwp_stack;
+      uwp_stack = c->prev;
+      free (c);
+    }
+  if (uwp_stack)
+    uwp_stack->used = 0;
 }
 
 static void
@@ -276,6 +387,8 @@ unwind_frame_run_internal (tag, ignore)
      char *tag, *ignore;
 {
   UNWIND_ELT *elt;
+  Function *cleanup;
+  char *arg;
   int found;
 
   found = 0;
@@ -292,16 +405,22 @@ unwind_frame_run_internal (tag, ignore)
 	      found = 1;
 	      break;
 	    }
+	  uwpfree (elt);
+	}
+      else if (elt->head.cleanup == (Function *) restore_variable)
+	{
+	  restore_variable (&elt->sv.v);
+	  uwpfree (elt);
 	}
       else
 	{
-	  if (elt->head.cleanup == (Function *) restore_variable)
-	    restore_variable (&elt->sv.v);
-	  else
-	    (*(elt->head.cleanup)) (elt->arg.v);
+	  /* Pop the element before calling the cleanup function, which
+	     may add and run unwind-protects of its own. */
+	  cleanup = elt->head.cleanup;
+	  arg = elt->arg.v;
+	  uwpfree (elt);
+	  (*cleanup) (arg);
 	}
-
-      uwpfree (elt);
     }
   if (tag && found == 0)
     internal_warning ("unwind_frame_run: %s: frame not found", tag);
@@ -317,7 +436,9 @@ unwind_protect_mem_internal (var, psize)
 
   size = *(int *) psize;
   allocated = size + offsetof (UNWIND_ELT, sv.v.desired_setting[0]);
-  elt = (UNWIND_ELT *)xmalloc (allocated);
+  if (allocated < sizeof (UNWIND_ELT))
+    allocated = sizeof (UNWIND_ELT);
+  elt = (UNWIND_ELT *)uwp_alloc (allocated);
   elt->head.next = unwind_protect_list;
   elt->head.cleanup = (Function *) restore_variable;
   elt->sv.v.variable = var;
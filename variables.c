@@ -146,6 +146,13 @@ pid_t dollar_dollar_pid;
 /* Non-zero means that we have to remake EXPORT_ENV. */
 int array_needs_making = 1;
 
+/* Freed SHELL_VARs, kept for reuse.  A function with many local variables
+   frees them all at once when it returns. */
+static sh_obj_cache_t vcache = {0, 0, 0};
+
+#define VCACHESIZE	32
+#define VCACHEMAX	1024
+
 /* The number of times BASH has been executed.  This is set
    by initialize_variables (). */
 int shell_level = 0;
@@ -219,6 +226,10 @@ static SHELL_VAR *get_dirstack __P((SHELL_VAR *));
 
 #if defined (ARRAY_VARS)
 static SHELL_VAR *get_groupset __P((SHELL_VAR *));
+#  if defined (READLINE)
+static SHELL_VAR *get_rloutput __P((SHELL_VAR *));
+#  endif
+static SHELL_VAR *get_objcache __P((SHELL_VAR *));
 
 static SHELL_VAR *build_hashcmd __P((SHELL_VAR *));
 static SHELL_VAR *get_hashcmd __P((SHELL_VAR *));
@@ -228,6 +239,11 @@ static SHELL_VAR *build_aliasvar __P((SHELL_VAR *));
 static SHELL_VAR *get_aliasvar __P((SHELL_VAR *));
 static SHELL_VAR *assign_aliasvar __P((SHELL_VAR *,  char *, arrayind_t, char *));
 #  endif
+static SHELL_VAR *get_bash_source __P((SHELL_VAR *));
+static SHELL_VAR *get_bash_lineno __P((SHELL_VAR *));
+static char *call_stack_string __P((char *));
+static void build_call_stack_array __P((SHELL_VAR *, int));
+static void sync_call_stack_vars __P((void));
 #endif
 
 static SHELL_VAR *get_funcname __P((SHELL_VAR *));
@@ -313,6 +329,7 @@ initialize_shell_variables (env, privmode)
   int c, char_index, string_index, string_length;
   SHELL_VAR *temp_var;
 
+  ocache_create_growable (vcache, SHELL_VAR, VCACHESIZE, VCACHEMAX, "variable");
   create_variable_tables ();
 
   for (string_index = 0; string = env[string_index++]; )
@@ -1510,11 +1527,57 @@ get_groupset (self)
   return (self);
 }
 
+#if defined (READLINE)
+/* READLINE_OUTPUT holds the number of keys readline has read and the
+   number of bytes and writes it has sent to the terminal. */
+static SHELL_VAR *
+get_rloutput (self)
+     SHELL_VAR *self;
+{
+  ARRAY *a;
+  char ibuf[INT_STRLEN_BOUND (unsigned long) + 1];
+
+  a = array_cell (self);
+  array_flush (a);
+  array_insert (a, 0, fmtulong (rl_keys_read, 10, ibuf, sizeof (ibuf), 0));
+  array_insert (a, 1, fmtulong (rl_output_bytes, 10, ibuf, sizeof (ibuf), 0));
+  array_insert (a, 2, fmtulong (rl_output_writes, 10, ibuf, sizeof (ibuf), 0));
+  return (self);
+}
+#endif
+
+/* BASH_OBJCACHE maps the name of each object cache to its statistics:
+   objects allocated, allocations the cache satisfied, objects freed, frees
+   that found the cache full, objects cached, and the cache size. */
+static SHELL_VAR *
+get_objcache (self)
+     SHELL_VAR *self;
+{
+  ASSOC_TABLE *h;
+  sh_obj_cache_t *c;
+  char v[6 * (INT_STRLEN_BOUND (unsigned long) + 1)];
+
+  h = assoc_cell (self);
+  if (h)
+    assoc_dispose (h);
+
+  h = assoc_create (0);
+  for (c = ocache_list (); c; c = c->next)
+    {
+      sprintf (v, "%lu %lu %lu %lu %d %d", c->nalloc, c->nhit, c->nfree,
+	       c->nspill, c->nc, c->cs);
+      assoc_insert (h, savestring (c->name), v);
+    }
+
+  var_setvalue (self, (char *)h);
+  return (self);
+}
+
 static SHELL_VAR *
 build_hashcmd (self)
      SHELL_VAR *self;
 {
-  HASH_TABLE *h;
+  ASSOC_TABLE *h;
   int i;
   char *k, *v;
   BUCKET_CONTENTS *item;
@@ -1529,7 +1592,7 @@ build_hashcmd (self)
       return self;
     }
 
-  h = assoc_create (hashed_filenames->nbuckets);
+  h = assoc_create (HASH_ENTRIES (hashed_filenames));
   for (i = 0; i < hashed_filenames->nbuckets; i++)
     {
       for (item = hash_items (i, hashed_filenames); item; item = item->next)
@@ -1568,7 +1631,7 @@ static SHELL_VAR *
 build_aliasvar (self)
      SHELL_VAR *self;
 {
-  HASH_TABLE *h;
+  ASSOC_TABLE *h;
   int i;
   char *k, *v;
   BUCKET_CONTENTS *item;
@@ -1583,7 +1646,7 @@ build_aliasvar (self)
       return self;
     }
 
-  h = assoc_create (aliases->nbuckets);
+  h = assoc_create (HASH_ENTRIES (aliases));
   for (i = 0; i < aliases->nbuckets; i++)
     {
       for (item = hash_items (i, aliases); item; item = item->next)
@@ -1618,6 +1681,156 @@ assign_aliasvar (self, value, ind, key)
 }
 #endif /* ALIAS */
 
+/* The shell's call stack: a frame for the script, each file being sourced
+   and each shell function being executed, most recent last.  FUNCNAME,
+   BASH_SOURCE and BASH_LINENO are built from it only when they are
+   referenced, so calling a function doesn't have to shift every element
+   of three arrays.  The strings in the frames are kept in
+   call_stack_strings and never freed, since a function may be unset or
+   redefined while it is executing. */
+typedef struct call_frame {
+  char *funcname;
+  char *source;
+  int line;
+} CALL_FRAME;
+
+#define CALL_FRAME_FUNCNAME	0
+#define CALL_FRAME_SOURCE	1
+#define CALL_FRAME_LINENO	2
+
+static CALL_FRAME *call_stack = (CALL_FRAME *)NULL;
+static int call_stack_size;
+static int call_stack_depth;
+
+/* Incremented each time the call stack changes.  Each array records the
+   value it was last built for. */
+static unsigned long call_stack_serial = 1;
+static unsigned long call_stack_built[3];
+
+static HASH_TABLE *call_stack_strings = (HASH_TABLE *)NULL;
+
+static char *
+call_stack_string (s)
+     char *s;
+{
+  BUCKET_CONTENTS *item;
+
+  if (call_stack_strings == 0)
+    call_stack_strings = hash_create (64);
+  item = hash_search (s, call_stack_strings, 0);
+  if (item == 0)
+    item = hash_insert (savestring (s), call_stack_strings, HASH_NOSRCH);
+  return (item->key);
+}
+
+/* Add a frame for FUNCNAME, defined in or reading from the file SOURCE,
+   called from line LINE. */
+void
+push_call_frame (funcname, source, line)
+     char *funcname, *source;
+     int line;
+{
+  CALL_FRAME *f;
+
+  if (call_stack_depth + 1 > call_stack_size)
+    call_stack = (CALL_FRAME *)xrealloc (call_stack, (call_stack_size += 16) * sizeof (CALL_FRAME));
+
+  f = call_stack + call_stack_depth++;
+  f->funcname = call_stack_string (funcname);
+  f->source = call_stack_string (source ? source : "");
+  f->line = line;
+  call_stack_serial++;
+}
+
+void
+pop_call_frame ()
+{
+  if (call_stack_depth > 0)
+    {
+      call_stack_depth--;
+      call_stack_serial++;
+    }
+}
+
+/* Forget every frame; the shell is starting afresh. */
+void
+clear_call_stack ()
+{
+  call_stack_depth = 0;
+  call_stack_serial++;
+}
+
+/* Make the array variable SELF reflect the WHICH member of each frame of
+   the call stack, the most recent frame at index 0. */
+static void
+build_call_stack_array (self, which)
+     SHELL_VAR *self;
+     int which;
+{
+  ARRAY *a;
+  CALL_FRAME *f;
+  arrayind_t i;
+  char *t;
+
+  a = array_cell (self);
+  if (a == 0 || call_stack_built[which] == call_stack_serial)
+    return;
+
+  array_flush (a);
+  for (i = 0; i < call_stack_depth; i++)
+    {
+      f = call_stack + call_stack_depth - i - 1;
+      switch (which)
+	{
+	case CALL_FRAME_FUNCNAME:
+	  array_insert (a, i, f->funcname);
+	  break;
+	case CALL_FRAME_SOURCE:
+	  array_insert (a, i, f->source);
+	  break;
+	case CALL_FRAME_LINENO:
+	  t = itos (f->line);
+	  array_insert (a, i, t);
+	  free (t);
+	  break;
+	}
+    }
+  call_stack_built[which] = call_stack_serial;
+}
+
+static SHELL_VAR *
+get_bash_source (self)
+     SHELL_VAR *self;
+{
+  build_call_stack_array (self, CALL_FRAME_SOURCE);
+  return (self);
+}
+
+static SHELL_VAR *
+get_bash_lineno (self)
+     SHELL_VAR *self;
+{
+  build_call_stack_array (self, CALL_FRAME_LINENO);
+  return (self);
+}
+
+/* Bring the call stack arrays up to date before the variables are listed
+   without being looked up by name. */
+static void
+sync_call_stack_vars ()
+{
+  static char *names[] = { "FUNCNAME", "BASH_SOURCE", "BASH_LINENO", (char *)NULL };
+  SHELL_VAR *v;
+  int i;
+
+  for (i = 0; names[i]; i++)
+    {
+      v = hash_lookup (names[i], global_variables->table);
+      if (v && v->dynamic_value && array_p (v))
+	(*(v->dynamic_value)) (v);
+    }
+}
+
 #endif /* ARRAY_VARS */
 
 /* If ARRAY_VARS is not defined, this just returns the name of any
@@ -1634,17 +1847,21 @@ get_funcname (self)
       t = savestring (this_shell_function->name);
       var_setvalue (self, t);
     }
+#else
+  build_call_stack_array (self, CALL_FRAME_FUNCNAME);
 #endif
   return (self);
 }
 
+/* Called on every function call and return, so this doesn't use
+   find_variable, which would rebuild the call stack array. */
 void
 make_funcname_visible (on_or_off)
      int on_or_off;
 {
   SHELL_VAR *v;
 
-  v = find_variable ("FUNCNAME");
+  v = hash_lookup ("FUNCNAME", global_variables->table);
   if (v == 0 || v->dynamic_value == 0)
     return;
 
@@ -1704,15 +1921,19 @@ initialize_dynamic_variables ()
 
 #if defined (ARRAY_VARS)
   v = init_dynamic_array_var ("GROUPS", get_groupset, null_array_assign, att_noassign);
+#  if defined (READLINE)
+  v = init_dynamic_array_var ("READLINE_OUTPUT", get_rloutput, null_array_assign, att_noassign);
+#  endif
 
 #  if defined (DEBUGGER)
   v = init_dynamic_array_var ("BASH_ARGC", get_self, null_array_assign, att_noassign|att_nounset);
   v = init_dynamic_array_var ("BASH_ARGV", get_self, null_array_assign, att_noassign|att_nounset);
 #  endif /* DEBUGGER */
-  v = init_dynamic_array_var ("BASH_SOURCE", get_self, null_array_assign, att_noassign|att_nounset);
-  v = init_dynamic_array_var ("BASH_LINENO", get_self, null_array_assign, att_noassign|att_nounset);
+  v = init_dynamic_array_var ("BASH_SOURCE", get_bash_source, null_array_assign, att_noassign|att_nounset);
+  v = init_dynamic_array_var ("BASH_LINENO", get_bash_lineno, null_array_assign, att_noassign|att_nounset);
 
   v = init_dynamic_assoc_var ("BASH_CMDS", get_hashcmd, assign_hashcmd, att_nofree);
+  v = init_dynamic_assoc_var ("BASH_OBJCACHE", get_objcache, null_array_assign, att_noassign);
 #  if defined (ALIAS)
   v = init_dynamic_assoc_var ("BASH_ALIASES", get_aliasvar, assign_aliasvar, att_nofree);
 #  endif
@@ -1983,7 +2204,7 @@ new_shell_variable (name)
 {
   SHELL_VAR *entry;
 
-  entry = (SHELL_VAR *)xmalloc (sizeof (SHELL_VAR));
+  ocache_alloc (vcache, SHELL_VAR, entry);
 
   entry->name = savestring (name);
   var_setvalue (entry, (char *)NULL);
@@ -2064,7 +2285,7 @@ make_new_assoc_variable (name)
      char *name;
 {
   SHELL_VAR *entry;
-  HASH_TABLE *hash;
+  ASSOC_TABLE *hash;
 
   entry = make_new_variable (name, global_variables->table);
   hash = assoc_create (0);
@@ -2079,7 +2300,7 @@ make_local_assoc_variable (name)
      char *name;
 {
   SHELL_VAR *var;
-  HASH_TABLE *hash;
+  ASSOC_TABLE *hash;
 
   var = make_local_variable (name);
   if (var == 0 || assoc_p (var))
@@ -2649,7 +2870,7 @@ dispose_variable (var)
   if (exported_p (var))
     array_needs_making = 1;
 
-  free (var);
+  ocache_free (vcache, SHELL_VAR, var);
 }
 
 /* Unset the shell variable referenced by NAME. */
@@ -2686,7 +2907,7 @@ unbind_func (name)
     }
 
   free (elt->key);
-  free (elt);
+  hash_free_item (elt);
 
   return 0;  
 }
@@ -2709,7 +2930,7 @@ unbind_function_def (name)
     dispose_function_def (funcdef);
 
   free (elt->key);
-  free (elt);
+  hash_free_item (elt);
 
   return 0;  
 }
@@ -2773,7 +2994,7 @@ makunbound (name, vc)
       stupidly_hack_special_variables (old_var->name);
 
       free (elt->key);
-      free (elt);
+      hash_free_item (elt);
       return (0);
     }
 
@@ -2783,7 +3004,7 @@ makunbound (name, vc)
   t = savestring (name);
 
   free (elt->key);
-  free (elt);
+  hash_free_item (elt);
 
   dispose_variable (old_var);
   stupidly_hack_special_variables (t);
@@ -3065,6 +3286,9 @@ vapply (func)
 {
   SHELL_VAR **list;
 
+#if defined (ARRAY_VARS)
+  sync_call_stack_vars ();
+#endif
   list = map_over (func, shell_variables);
   if (list /* && posixly_correct */)
     sort_variables (list);
@@ -4023,10 +4247,20 @@ pop_scope (is_special)
 /*								    */
 /* **************************************************************** */
 
-static WORD_LIST **dollar_arg_stack = (WORD_LIST **)NULL;
+/* A saved set of positional parameters.  Saving and restoring them just
+   moves the strings between here and dollar_vars and rest_of_args, so a
+   function call doesn't copy its caller's arguments. */
+typedef struct saved_dollar_vars {
+  char *first_ten[10];		/* [1]..[9]; $0 isn't saved */
+  WORD_LIST *rest;
+} SAVED_DOLLAR_VARS;
+
+static SAVED_DOLLAR_VARS *dollar_arg_stack = (SAVED_DOLLAR_VARS *)NULL;
 static int dollar_arg_stack_slots;
 static int dollar_arg_stack_index;
 
+static void free_saved_dollar_vars __P((SAVED_DOLLAR_VARS *));
+
 /* XXX - we might want to consider pushing and popping the `getopts' state
    when we modify the positional parameters. */
 void
@@ -4053,41 +4287,71 @@ pop_context ()
   sv_ifs ("IFS");		/* XXX here for now */
 }
 
-/* Save the existing positional parameters on a stack. */
+/* Save the existing positional parameters on a stack.  The positional
+   parameters are left unset. */
 void
 push_dollar_vars ()
 {
-  if (dollar_arg_stack_index + 2 > dollar_arg_stack_slots)
+  SAVED_DOLLAR_VARS *sv;
+  register int i;
+
+  if (dollar_arg_stack_index + 1 > dollar_arg_stack_slots)
     {
-      dollar_arg_stack = (WORD_LIST **)
+      dollar_arg_stack = (SAVED_DOLLAR_VARS *)
 	xrealloc (dollar_arg_stack, (dollar_arg_stack_slots += 10)
-		  * sizeof (WORD_LIST **));
+		  * sizeof (SAVED_DOLLAR_VARS));
+    }
+  sv = dollar_arg_stack + dollar_arg_stack_index++;
+  for (i = 1; i < 10; i++)
+    {
+      sv->first_ten[i] = dollar_vars[i];
+      dollar_vars[i] = (char *)NULL;
     }
-  dollar_arg_stack[dollar_arg_stack_index++] = list_rest_of_args ();
-  dollar_arg_stack[dollar_arg_stack_index] = (WORD_LIST *)NULL;
+  sv->rest = rest_of_args;
+  rest_of_args = (WORD_LIST *)NULL;
 }
 
 /* Restore the positional parameters from our stack. */
 void
 pop_dollar_vars ()
 {
+  SAVED_DOLLAR_VARS *sv;
+  register int i;
+
   if (!dollar_arg_stack || dollar_arg_stack_index == 0)
     return;
 
-  remember_args (dollar_arg_stack[--dollar_arg_stack_index], 1);
-  dispose_words (dollar_arg_stack[dollar_arg_stack_index]);
-  dollar_arg_stack[dollar_arg_stack_index] = (WORD_LIST *)NULL;
+  sv = dollar_arg_stack + --dollar_arg_stack_index;
+  for (i = 1; i < 10; i++)
+    {
+      FREE (dollar_vars[i]);
+      dollar_vars[i] = sv->first_ten[i];
+    }
+  dispose_words (rest_of_args);
+  rest_of_args = sv->rest;
   set_dollar_vars_unchanged ();
 }
 
+/* Throw away the most recently saved positional parameters, keeping the
+   current ones. */
 void
 dispose_saved_dollar_vars ()
 {
   if (!dollar_arg_stack || dollar_arg_stack_index == 0)
     return;
 
-  dispose_words (dollar_arg_stack[dollar_arg_stack_index]);
-  dollar_arg_stack[dollar_arg_stack_index] = (WORD_LIST *)NULL;
+  free_saved_dollar_vars (dollar_arg_stack + --dollar_arg_stack_index);
+}
+
+static void
+free_saved_dollar_vars (sv)
+     SAVED_DOLLAR_VARS *sv;
+{
+  register int i;
+
+  for (i = 1; i < 10; i++)
+    FREE (sv->first_ten[i]);
+  dispose_words (sv->rest);
 }
 
 /* Manipulate the special BASH_ARGV and BASH_ARGC variables. */
@@ -4486,7 +4750,7 @@ sv_histsize (name)
 	    }
 	  else
 	    {
-	      history_truncate_file (get_string_value ("HISTFILE"), hmax);
+	      bash_history_truncate_file (get_string_value ("HISTFILE"), hmax);
 	      if (hmax <= history_lines_in_file)
 		history_lines_in_file = hmax;
 	    }
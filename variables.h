@@ -70,7 +70,7 @@ union _value {
   intmax_t i;			/* int value */
   COMMAND *f;			/* function */
   ARRAY *a;			/* array */
-  HASH_TABLE *h;		/* associative array */
+  ASSOC_TABLE *h;		/* associative array */
   double d;			/* floating point number */
 #if defined (HAVE_LONG_DOUBLE)
   long double ld;		/* long double */
@@ -158,7 +158,7 @@ typedef struct _vlist {
 #define value_cell(var)		((var)->value)
 #define function_cell(var)	(COMMAND *)((var)->value)
 #define array_cell(var)		(ARRAY *)((var)->value)
-#define assoc_cell(var)		(HASH_TABLE *)((var)->value)
+#define assoc_cell(var)		(ASSOC_TABLE *)((var)->value)
 
 #define var_isnull(var)		((var)->value == 0)
 #define var_isset(var)		((var)->value != 0)
@@ -296,6 +296,12 @@ extern void dispose_saved_dollar_vars __P((void));
 extern void push_args __P((WORD_LIST *));
 extern void pop_args __P((void));
 
+#if defined (ARRAY_VARS)
+extern void push_call_frame __P((char *, char *, int));
+extern void pop_call_frame __P((void));
+extern void clear_call_stack __P((void));
+#endif
+
 extern void adjust_shell_level __P((int));
 extern void non_unsettable __P((char *));
 extern void dispose_variable __P((SHELL_VAR *));